@@ -3,11 +3,58 @@
 BufferManager::BufferManager()
 {
     logger.log("BufferManager::BufferManager");
+    this->ioThread = thread(&BufferManager::runIoTasks, this);
+}
+
+/**
+ * @brief Lets the I/O thread finish the tasks already queued and stops it.
+ *
+ */
+BufferManager::~BufferManager()
+{
+    {
+        lock_guard<mutex> lock(this->ioMutex);
+        this->ioStopping = true;
+    }
+    this->ioCondition.notify_all();
+    this->ioThread.join();
+}
+
+void BufferManager::queueIoTask(function<void()> task)
+{
+    {
+        lock_guard<mutex> lock(this->ioMutex);
+        this->ioTasks.push_back(move(task));
+    }
+    this->ioCondition.notify_one();
+}
+
+/**
+ * @brief Body of the I/O thread, which runs the queued prefetches and writes
+ * in the order they were queued until the buffer manager is destroyed.
+ *
+ */
+void BufferManager::runIoTasks()
+{
+    while (true)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(this->ioMutex);
+            this->ioCondition.wait(lock, [this]() { return this->ioStopping || !this->ioTasks.empty(); });
+            if (this->ioTasks.empty())
+                return;
+            task = move(this->ioTasks.front());
+            this->ioTasks.pop_front();
+        }
+        task();
+    }
 }
 
 /**
  * @brief Function called to read a page from the buffer manager. If the page is
  * not present in the pool, the page is read and then inserted into the pool.
+ * The pool is shared by all threads and guarded by poolMutex.
  *
  * @param tableName 
  * @param pageIndex 
@@ -15,14 +62,16 @@ BufferManager::BufferManager()
  */
 Page BufferManager::getPage(string tableName, int pageIndex, bool isMatrix)
 {
-    logger.log("BufferManager::getPage");
+    LOG_DEBUG("BufferManager::getPage");
     BLOCKS_READ++;
 
     string pageName = "../data/temp/"+tableName + "_Page" + to_string(pageIndex);
-    if (this->inPool(pageName))
-        return this->getFromPool(pageName);
-    else
-        return this->insertIntoPool(tableName, pageIndex, isMatrix);
+    {
+        lock_guard<mutex> lock(this->poolMutex);
+        if (this->inPool(pageName))
+            return this->getFromPool(pageName);
+    }
+    return this->insertIntoPool(tableName, pageIndex, isMatrix);
 }
 
 /**
@@ -34,8 +83,8 @@ Page BufferManager::getPage(string tableName, int pageIndex, bool isMatrix)
  */
 bool BufferManager::inPool(string pageName)
 {
-    logger.log("BufferManager::inPool");
-    for (auto page : this->pages)
+    LOG_DEBUG("BufferManager::inPool");
+    for (auto &page : this->pages)
     {
         if (pageName == page.pageName)
             return true;
@@ -53,8 +102,8 @@ bool BufferManager::inPool(string pageName)
  */
 Page BufferManager::getFromPool(string pageName)
 {
-    logger.log("BufferManager::getFromPool");
-    for (auto page : this->pages)
+    LOG_DEBUG("BufferManager::getFromPool");
+    for (auto &page : this->pages)
         if (pageName == page.pageName)
             return page;
 }
@@ -63,6 +112,8 @@ Page BufferManager::getFromPool(string pageName)
  * @brief Inserts page indicated by tableName and pageIndex into pool. If the
  * pool is full, the pool ejects the oldest inserted page from the pool and adds
  * the current page at the end. It naturally follows a queue data structure. 
+ * The page is read from disk before the pool is locked, so threads reading
+ * different pages don't wait on each other.
  *
  * @param tableName 
  * @param pageIndex 
@@ -70,8 +121,9 @@ Page BufferManager::getFromPool(string pageName)
  */
 Page BufferManager::insertIntoPool(string tableName, int pageIndex, bool isMatrix)
 {
-    logger.log("BufferManager::insertIntoPool");
+    LOG_DEBUG("BufferManager::insertIntoPool");
     Page page(tableName, pageIndex, isMatrix);
+    lock_guard<mutex> lock(this->poolMutex);
     if (this->pages.size() >= BLOCK_COUNT)
         pages.pop_front();
     pages.push_back(page);
@@ -79,7 +131,8 @@ Page BufferManager::insertIntoPool(string tableName, int pageIndex, bool isMatri
 }
 
 void BufferManager::deleteFromPool(string pageName) {
-    logger.log("BufferManager::deleteFromPool");
+    LOG_DEBUG("BufferManager::deleteFromPool");
+    lock_guard<mutex> lock(this->poolMutex);
     int sz = pages.size();
     while(sz--) {
         if(pages.front().pageName != pageName) {
@@ -91,20 +144,67 @@ void BufferManager::deleteFromPool(string pageName) {
 
 /**
  * @brief The buffer manager is also responsible for writing pages. This is
- * called when new tables are created using assignment statements.
+ * called when new tables are created using assignment statements. A copy of
+ * the page still held in the pool is dropped so that it is never read stale.
+ * A page shared with other relations is detached before it is written.
  *
  * @param tableName 
  * @param pageIndex 
  * @param rows 
  * @param rowCount 
  */
-void BufferManager::writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount)
+void BufferManager::writePage(string tableName, int pageIndex, const vector<vector<int>> &rows, int rowCount)
 {
-    logger.log("BufferManager::writePage");
+    LOG_DEBUG("BufferManager::writePage");
     BLOCKS_WRITTEN++;
     
-    Page page(tableName, pageIndex, rows, rowCount);
-    page.writePage();
+    string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
+    this->detachPage(pageName);
+    Page::writeRows(pageName, rows, rowCount);
+    this->deleteFromPool(pageName);
+}
+
+/**
+ * @brief Reads a page on the I/O thread, so that the caller can keep working
+ * on the pages it already holds while the read is in flight. The page goes
+ * through the pool like any other read. The caller must wait for the returned
+ * future before the relation can be deleted.
+ *
+ * @param tableName 
+ * @param pageIndex 
+ * @param isMatrix 
+ * @return future<Page> 
+ */
+future<Page> BufferManager::prefetchPage(string tableName, int pageIndex, bool isMatrix)
+{
+    LOG_DEBUG("BufferManager::prefetchPage");
+    auto task = make_shared<packaged_task<Page()>>([this, tableName, pageIndex, isMatrix]() {
+        return this->getPage(tableName, pageIndex, isMatrix);
+    });
+    future<Page> page = task->get_future();
+    this->queueIoTask([task]() { (*task)(); });
+    return page;
+}
+
+/**
+ * @brief Writes a page on the I/O thread. The caller must leave rows untouched
+ * until the returned future is ready.
+ *
+ * @param tableName 
+ * @param pageIndex 
+ * @param rows 
+ * @param rowCount 
+ * @return future<void> 
+ */
+future<void> BufferManager::writePageAsync(string tableName, int pageIndex, const vector<vector<int>> &rows, int rowCount)
+{
+    LOG_DEBUG("BufferManager::writePageAsync");
+    auto task = make_shared<packaged_task<void()>>([this, tableName, pageIndex, &rows, rowCount]() {
+        this->writePage(tableName, pageIndex, rows, rowCount);
+    });
+    future<void> written = task->get_future();
+    this->queueIoTask([task]() { (*task)(); });
+    return written;
 }
 
 /**
@@ -114,7 +214,7 @@ void BufferManager::writePage(string tableName, int pageIndex, vector<vector<int
  */
 void BufferManager::deleteFile(string fileName)
 {
-    
+    this->deleteFromPool(fileName);
     if (remove(fileName.c_str()))
         logger.log("BufferManager::deleteFile: Err");
     else logger.log("BufferManager::deleteFile: Success");
@@ -146,4 +246,44 @@ void BufferManager::renameFile(string tableName, string newTableName, int pageIn
 
     this->deleteFromPool(curFileName);
     this->deleteFromPool(newFileName);
-}
\ No newline at end of file
+}
+/**
+ * @brief Makes page newPageIndex of newTableName refer to the same page file
+ * as page pageIndex of tableName, without copying it. Any file already stored
+ * under the new page name is replaced.
+ *
+ * @param tableName 
+ * @param pageIndex 
+ * @param newTableName 
+ * @param newPageIndex 
+ * @return true if the page is shared
+ * @return false if the file system can't link the page file, the caller has
+ * to copy it instead
+ */
+bool BufferManager::sharePage(string tableName, int pageIndex, string newTableName, int newPageIndex)
+{
+    LOG_DEBUG("BufferManager::sharePage");
+    string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
+    string newPageName = "../data/temp/" + newTableName + "_Page" + to_string(newPageIndex);
+    remove(newPageName.c_str());
+    this->deleteFromPool(newPageName);
+    return link(pageName.c_str(), newPageName.c_str()) == 0;
+}
+
+/**
+ * @brief Gives a relation a private copy of its page before the page is
+ * overwritten, if the page file is shared. The relation's reference is dropped
+ * and the caller writes a new file in its place. Pages of the relations still
+ * sharing the old file are left as they are.
+ *
+ * @param pageName 
+ */
+void BufferManager::detachPage(string pageName)
+{
+    struct stat pageStatus;
+    if (stat(pageName.c_str(), &pageStatus) == 0 && pageStatus.st_nlink > 1)
+    {
+        LOG_DEBUG("BufferManager::detachPage");
+        remove(pageName.c_str());
+    }
+}
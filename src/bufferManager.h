@@ -1,4 +1,5 @@
 #include"page.h"
+#include<unistd.h>
 
 /**
  * @brief The BufferManager is responsible for reading pages to the main memory.
@@ -19,21 +20,48 @@
  * was previously present in the buffer or was read in from the disk. 
  * </p>
  *
+ * <p>
+ * A page file can be shared by several relations (see sharePage). Each
+ * relation refers to it by its own page name, a hard link to the same file, so
+ * the file system counts the references and deleting a relation's page only
+ * drops its reference. Writing a page that is still shared first detaches it,
+ * so the write goes to a private copy and the other relations are unaffected.
+ * </p>
+ *
+ * <p>
+ * Prefetches and asynchronous writes are queued to a single I/O thread that
+ * lives as long as the buffer manager, rather than each starting a thread of
+ * its own.
+ * </p>
+ *
  */
 class BufferManager{
 
     deque<Page> pages; 
+    mutex poolMutex;
+    deque<function<void()>> ioTasks;
+    mutex ioMutex;
+    condition_variable ioCondition;
+    bool ioStopping = false;
+    thread ioThread;
     bool inPool(string pageName);
     Page getFromPool(string pageName);
     Page insertIntoPool(string tableName, int pageIndex, bool isMatrix);
+    void detachPage(string pageName);
+    void queueIoTask(function<void()> task);
+    void runIoTasks();
 
     public:
     BufferManager();
+    ~BufferManager();
     Page getPage(string tableName, int pageIndex, bool isMatrix);
     void writePage(string pageName, vector<vector<int>> rows);
     void deleteFile(string tableName, int pageIndex);
     void deleteFile(string fileName);
-    void writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount);
+    void writePage(string tableName, int pageIndex, const vector<vector<int>> &rows, int rowCount);
+    future<Page> prefetchPage(string tableName, int pageIndex, bool isMatrix);
+    future<void> writePageAsync(string tableName, int pageIndex, const vector<vector<int>> &rows, int rowCount);
     void renameFile(string tableName, string newTableName, int pageIndex);
+    bool sharePage(string tableName, int pageIndex, string newTableName, int newPageIndex);
     void deleteFromPool(string pageName);
 };
\ No newline at end of file
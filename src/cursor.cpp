@@ -2,7 +2,7 @@
 
 Cursor::Cursor(string tableName, int pageIndex)
 {
-    logger.log("Cursor::Cursor");
+    LOG_DEBUG("Cursor::Cursor");
     this->page = bufferManager.getPage(tableName, pageIndex, this->isMatrix);
     this->pagePointer = 0;
     this->tableName = tableName;
@@ -11,7 +11,7 @@ Cursor::Cursor(string tableName, int pageIndex)
 
 Cursor::Cursor(string tableName, int pageIndex, bool isMatrix)
 {
-    logger.log("Cursor::Cursor");
+    LOG_DEBUG("Cursor::Cursor");
     this->page = bufferManager.getPage(tableName, pageIndex, isMatrix);
     this->pagePointer = 0;
     this->tableName = tableName;
@@ -28,7 +28,7 @@ Cursor::Cursor(string tableName, int pageIndex, bool isMatrix)
  */
 vector<int> Cursor::getNext()
 {
-    logger.log("Cursor::geNext");
+    LOG_TRACE("Cursor::getNext");
     vector<int> result = this->page.getRow(this->pagePointer);
     this->pagePointer++;
     if(result.empty()){
@@ -43,7 +43,7 @@ vector<int> Cursor::getNext()
 
 vector<int> Cursor::getNextPageRow()
 {
-    logger.log("Cursor::geNgetNextMatrixPageext");
+    LOG_TRACE("Cursor::getNextPageRow");
     vector<int> result = this->page.getRow(this->pagePointer);
     this->pagePointer++;
     if(result.empty()){
@@ -57,7 +57,7 @@ vector<int> Cursor::getNextPageRow()
 }
 
 vector<vector<int>> Cursor::getPage() {
-    logger.log("Cursor::getPage");
+    LOG_DEBUG("Cursor::getPage");
     vector<vector<int>> result = this->page.getRows();
     return result;
 }
@@ -71,7 +71,7 @@ vector<vector<int>> Cursor::getPage() {
  */
 void Cursor::nextPage(int pageIndex)
 {
-    logger.log("Cursor::nextPage");
+    LOG_DEBUG("Cursor::nextPage");
     this->page = bufferManager.getPage(this->tableName, pageIndex, this->isMatrix);
     this->pageIndex = pageIndex;
     this->pagePointer = 0;
@@ -26,6 +26,8 @@ void executeCommand(){
         case COMPUTE: executeCOMPUTE(); break;
         case ORDER: executeORDER(); break;
         case GROUP: executeGROUP(); break;
+        case SEMIJOIN: executeSEMIJOIN(); break;
+        case ANTIJOIN: executeANTIJOIN(); break;
         default: cout<<"PARSING ERROR"<<endl;
     }
 
@@ -35,4 +37,51 @@ void executeCommand(){
 void printRowCount(int rowCount){
     cout<<"\n\nRow Count: "<<rowCount<<endl;
     return;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Runs task(0) ... task(taskCount - 1) on up to THREAD_COUNT threads,
+ * or fewer if threadLimit is smaller (for tasks that split the buffer pool
+ * between them). Threads pick the next task as they finish their previous
+ * one, so tasks of uneven size balance out. With a single task or thread
+ * everything runs on the calling thread.
+ *
+ * @param taskCount 
+ * @param task 
+ * @param threadLimit 
+ */
+void parallelFor(uint taskCount, function<void(uint)> task, uint threadLimit)
+{
+    uint threadCount = min({THREAD_COUNT, threadLimit, taskCount});
+    if (threadCount <= 1)
+    {
+        for (uint taskCounter = 0; taskCounter < taskCount; taskCounter++)
+            task(taskCounter);
+        return;
+    }
+
+    atomic<uint> nextTask(0);
+    vector<thread> threads;
+    for (uint threadCounter = 0; threadCounter < threadCount; threadCounter++)
+    {
+        threads.emplace_back([&nextTask, &task, taskCount]() {
+            for (uint taskCounter = nextTask++; taskCounter < taskCount; taskCounter = nextTask++)
+                task(taskCounter);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+}
+
+/**
+ * @brief Number of buffer frames an operator may fill with data pages once
+ * reservedFrames are kept aside for the pages it reads and writes. Never
+ * returns less than one, so small BLOCK_COUNT settings cannot wrap around.
+ *
+ * @param reservedFrames 
+ * @return uint 
+ */
+uint memoryFrames(uint reservedFrames)
+{
+    return BLOCK_COUNT > reservedFrames ? BLOCK_COUNT - reservedFrames : 1;
+}
@@ -25,6 +25,10 @@ void executeCHECKSYMMETRY();
 void executeCOMPUTE();
 void executeORDER();
 void executeGROUP();
+void executeSEMIJOIN();
+void executeANTIJOIN();
 
-bool evaluateBinOp(int value1, int value2, BinaryOperator binaryOperator);
-void printRowCount(int rowCount);
\ No newline at end of file
+bool evaluateBinOp(long long int value1, long long int value2, BinaryOperator binaryOperator);
+void printRowCount(int rowCount);
+void parallelFor(uint taskCount, function<void(uint)> task, uint threadLimit = UINT_MAX);
+uint memoryFrames(uint reservedFrames);
\ No newline at end of file
@@ -41,63 +41,52 @@ void executeCROSS()
 {
     logger.log("executeCROSS");
 
-    Table table1 = *(tableCatalogue.getTable(parsedQuery.crossFirstRelationName));
-    Table table2 = *(tableCatalogue.getTable(parsedQuery.crossSecondRelationName));
+    Table *table1 = tableCatalogue.getTable(parsedQuery.crossFirstRelationName);
+    Table *table2 = tableCatalogue.getTable(parsedQuery.crossSecondRelationName);
 
     vector<string> columns;
 
     //If both tables are the same i.e. CROSS a a, then names are indexed as a1 and a2
-    if(table1.tableName == table2.tableName){
+    if(table1->tableName == table2->tableName){
         parsedQuery.crossFirstRelationName += "1";
         parsedQuery.crossSecondRelationName += "2";
     }
 
     //Creating list of column names
-    for (int columnCounter = 0; columnCounter < table1.columnCount; columnCounter++)
+    for (int columnCounter = 0; columnCounter < table1->columnCount; columnCounter++)
     {
-        string columnName = table1.columns[columnCounter];
-        if (table2.isColumn(columnName))
+        string columnName = table1->columns[columnCounter];
+        if (table2->isColumn(columnName))
         {
             columnName = parsedQuery.crossFirstRelationName + "_" + columnName;
         }
         columns.emplace_back(columnName);
     }
 
-    for (int columnCounter = 0; columnCounter < table2.columnCount; columnCounter++)
+    for (int columnCounter = 0; columnCounter < table2->columnCount; columnCounter++)
     {
-        string columnName = table2.columns[columnCounter];
-        if (table1.isColumn(columnName))
+        string columnName = table2->columns[columnCounter];
+        if (table1->isColumn(columnName))
         {
             columnName = parsedQuery.crossSecondRelationName + "_" + columnName;
         }
         columns.emplace_back(columnName);
     }
 
-    Table *resultantTable = new Table(parsedQuery.crossResultRelationName, columns);\
-
-    Cursor cursor1 = table1.getCursor();
-    Cursor cursor2 = table2.getCursor();
-
-    vector<int> row1 = cursor1.getNext();
-    vector<int> row2;
-    vector<int> resultantRow;
-    resultantRow.reserve(resultantTable->columnCount);
-
-    while (!row1.empty())
+    //Warn before producing an output of a terabyte or more
+    long double estimatedRowCount = (long double)table1->rowCount * table2->rowCount;
+    long double estimatedByteCount = estimatedRowCount * columns.size() * sizeof(int);
+    if (estimatedByteCount >= CROSS_WARNING_BYTES)
     {
-
-        cursor2 = table2.getCursor();
-        row2 = cursor2.getNext();
-        while (!row2.empty())
-        {
-            resultantRow = row1;
-            resultantRow.insert(resultantRow.end(), row2.begin(), row2.end());
-            resultantTable->writeRow<int>(resultantRow);
-            row2 = cursor2.getNext();
-        }
-        row1 = cursor1.getNext();
+        cout << "WARNING: CROSS is estimated to produce " << (unsigned long long)estimatedRowCount << " rows (about " << (unsigned long long)(estimatedByteCount / 1e9) << " GB)" << endl;
+        LOG_WARN("executeCROSS: estimated output of " + to_string((unsigned long long)estimatedByteCount) + " bytes");
     }
-    resultantTable->blockify();
+
+    Table *resultantTable = new Table(parsedQuery.crossResultRelationName);
+    resultantTable->columns = columns;
+    resultantTable->columnCount = columns.size();
+    resultantTable->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * resultantTable->columnCount));
+    resultantTable->crossTable(table1, table2);
     tableCatalogue.insertTable(resultantTable);
     return;
-}
\ No newline at end of file
+}
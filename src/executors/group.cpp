@@ -1,15 +1,37 @@
 #include "global.h"
+/**
+ * @brief Splits an aggregate such as SUM(x) into its function and column.
+ * COUNT also takes *, to count the rows of a group.
+ *
+ * @param aggregate 
+ * @param aggregateFunction 
+ * @param columnName 
+ * @return true if the aggregate is well formed
+ */
+bool parseGroupAggregate(string aggregate, string &aggregateFunction, string &columnName)
+{
+    size_t openPosition = aggregate.find('(');
+    if (openPosition == string::npos || aggregate.size() <= openPosition + 2 || aggregate.back() != ')')
+        return false;
+    aggregateFunction = aggregate.substr(0, openPosition);
+    columnName = aggregate.substr(openPosition + 1, aggregate.size() - openPosition - 2);
+    if (aggregateFunction == "COUNT")
+        return true;
+    return (aggregateFunction == "SUM" || aggregateFunction == "MAX" || aggregateFunction == "MIN" || aggregateFunction == "AVG") && columnName != "*";
+}
+
 /**
  * @brief 
- * SYNTAX: R <- GROUP BY grouping_column_name FROM relation_name 
- * HAVING <aggregate(attribute)> <bin_op> <attribute_value> 
- * RETURN <aggregate_func(attribute)>
+ * SYNTAX: R <- GROUP BY grouping_column_name[, grouping_column_name ...] FROM relation_name 
+ * [HAVING <aggregate(attribute)> <bin_op> <attribute_value>]
+ * RETURN <aggregate_func(attribute)>[, <aggregate_func(attribute)> ...]
  */
 bool syntacticParseGROUP()
 {
-    logger.log("semanticParseGROUP");
+    logger.log("syntacticParseGROUP");
 
-    if (tokenizedQuery.size() != 13 || tokenizedQuery[3] != "BY" || tokenizedQuery[5] != "FROM" || tokenizedQuery[7] != "HAVING" || tokenizedQuery[11] != "RETURN")
+    int fromPosition = find(tokenizedQuery.begin(), tokenizedQuery.end(), "FROM") - tokenizedQuery.begin();
+    if (tokenizedQuery.size() < 9 || tokenizedQuery[3] != "BY" || fromPosition < 5 || fromPosition + 3 >= tokenizedQuery.size())
     {
         cout << "SYNTAX ERROR" << endl;
         return false;
@@ -17,77 +39,88 @@ bool syntacticParseGROUP()
 
     parsedQuery.queryType = GROUP;
     parsedQuery.groupResultRelationName = tokenizedQuery[0];
-    parsedQuery.groupRelationName = tokenizedQuery[6];
-    parsedQuery.groupColumnName = tokenizedQuery[4];
-
-    string binaryOperator = tokenizedQuery[9];
-    if (binaryOperator == "<")
-        parsedQuery.groupBinaryOperator = LESS_THAN;
-    else if (binaryOperator == ">")
-        parsedQuery.groupBinaryOperator = GREATER_THAN;
-    else if (binaryOperator == ">=" || binaryOperator == "=>")
-        parsedQuery.groupBinaryOperator = GEQ;
-    else if (binaryOperator == "<=" || binaryOperator == "=<")
-        parsedQuery.groupBinaryOperator = LEQ;
-    else if (binaryOperator == "==")
-        parsedQuery.groupBinaryOperator = EQUAL;
-    else if (binaryOperator == "!=")
-        parsedQuery.groupBinaryOperator = NOT_EQUAL;
-    else
-    {
-        cout << "SYNTAX ERROR" << endl;
-        return false;
-    }
+    parsedQuery.groupRelationName = tokenizedQuery[fromPosition + 1];
+    parsedQuery.groupColumnNames.assign(tokenizedQuery.begin() + 4, tokenizedQuery.begin() + fromPosition);
 
-    regex numeric("[-]?[0-9]+");
-    string attribute_value = tokenizedQuery[10];
-    if (regex_match(attribute_value, numeric))
-    {
-        parsedQuery.groupAggregateColumnValue = stoi(attribute_value);
-    }
-    else
+    int returnPosition = fromPosition + 2;
+    if (tokenizedQuery[returnPosition] == "HAVING")
     {
-        cout << "SYNTAX ERROR" << endl;
-        return false;
-    }
+        if (tokenizedQuery.size() < returnPosition + 6)
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
 
-    string aggregate_attribute_name = tokenizedQuery[8];
-    // cout << aggregate_attribute_name << " " << aggregate_attribute_name.size() << " " << aggregate_attribute_name[3] << " " << aggregate_attribute_name.back() << "\n";
-    if(aggregate_attribute_name.size() <= 5 || aggregate_attribute_name[3] != '(' || aggregate_attribute_name.back() != ')') {
-        cout << "SYNTAX ERROR" << endl;
-        return false;
-    }
-    string aggregate_function_name = aggregate_attribute_name.substr(0, 3);
-    if (aggregate_function_name == "SUM" || aggregate_function_name == "MAX" || aggregate_function_name == "MIN" || aggregate_function_name == "AVG") {
-        parsedQuery.groupAggregateFunction = aggregate_function_name;
-    }
-    else
-    {
-        cout << "SYNTAX ERROR" << endl;
-        return false;
+        string binaryOperator = tokenizedQuery[returnPosition + 2];
+        if (binaryOperator == "<")
+            parsedQuery.groupBinaryOperator = LESS_THAN;
+        else if (binaryOperator == ">")
+            parsedQuery.groupBinaryOperator = GREATER_THAN;
+        else if (binaryOperator == ">=" || binaryOperator == "=>")
+            parsedQuery.groupBinaryOperator = GEQ;
+        else if (binaryOperator == "<=" || binaryOperator == "=<")
+            parsedQuery.groupBinaryOperator = LEQ;
+        else if (binaryOperator == "==")
+            parsedQuery.groupBinaryOperator = EQUAL;
+        else if (binaryOperator == "!=")
+            parsedQuery.groupBinaryOperator = NOT_EQUAL;
+        else
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+
+        regex numeric("[-]?[0-9]+");
+        string attribute_value = tokenizedQuery[returnPosition + 3];
+        if (regex_match(attribute_value, numeric))
+        {
+            parsedQuery.groupAggregateColumnValue = stoi(attribute_value);
+        }
+        else
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+
+        if (!parseGroupAggregate(tokenizedQuery[returnPosition + 1], parsedQuery.groupAggregateFunction, parsedQuery.groupAggregateColumnName))
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+        returnPosition += 4;
     }
-    parsedQuery.groupAggregateColumnName = aggregate_attribute_name.substr(4, aggregate_attribute_name.size() - 5);
 
-    
-    string return_aggregate_attribute_name = tokenizedQuery[12];
-    if(return_aggregate_attribute_name.size() <= 5 || return_aggregate_attribute_name[3] != '(' || return_aggregate_attribute_name.back() != ')') {
+    if (tokenizedQuery[returnPosition] != "RETURN" || returnPosition + 1 >= tokenizedQuery.size())
+    {
         cout << "SYNTAX ERROR" << endl;
         return false;
     }
-    string return_aggregate_function_name = return_aggregate_attribute_name.substr(0, 3);
-    if (return_aggregate_function_name == "SUM" || return_aggregate_function_name == "MAX" || return_aggregate_function_name == "MIN" || return_aggregate_function_name == "AVG") {
-        parsedQuery.groupReturnAggregateFunction = return_aggregate_function_name;
-    }
-    else
+    for (int tokenCounter = returnPosition + 1; tokenCounter < tokenizedQuery.size(); tokenCounter++)
     {
-        cout << "SYNTAX ERROR" << endl;
-        return false;
+        string aggregateFunction, columnName;
+        if (!parseGroupAggregate(tokenizedQuery[tokenCounter], aggregateFunction, columnName))
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+        parsedQuery.groupReturnAggregates.emplace_back(aggregateFunction, columnName);
     }
-    parsedQuery.groupReturnAggregateColumnName = return_aggregate_attribute_name.substr(4, return_aggregate_attribute_name.size() - 5);
 
     return true;
 }
 
+/**
+ * @brief Name of the result column of a returned aggregate, the function
+ * followed by the column, so SUM(x) becomes SUMx and COUNT(*) just COUNT.
+ *
+ * @param returnAggregate 
+ * @return string 
+ */
+string getGroupResultColumnName(const pair<string, string> &returnAggregate)
+{
+    return returnAggregate.first + (returnAggregate.second == "*" ? "" : returnAggregate.second);
+}
+
 bool semanticParseGROUP()
 {
     logger.log("semanticParseGROUP");
@@ -104,66 +137,149 @@ bool semanticParseGROUP()
         return false;
     }
 
-    if (!tableCatalogue.isColumnFromTable(parsedQuery.groupColumnName, parsedQuery.groupRelationName) 
-        || !tableCatalogue.isColumnFromTable(parsedQuery.groupAggregateColumnName, parsedQuery.groupRelationName) 
-        || !tableCatalogue.isColumnFromTable(parsedQuery.groupReturnAggregateColumnName, parsedQuery.groupRelationName))
+    vector<string> columnNames = parsedQuery.groupColumnNames;
+    if (parsedQuery.groupBinaryOperator != NO_BINOP_CLAUSE && parsedQuery.groupAggregateColumnName != "*")
+        columnNames.push_back(parsedQuery.groupAggregateColumnName);
+    for (auto &returnAggregate : parsedQuery.groupReturnAggregates)
+        if (returnAggregate.second != "*")
+            columnNames.push_back(returnAggregate.second);
+    for (auto &columnName : columnNames)
     {
-        cout << "SEMANTIC ERROR: Column doesn't exist in relation" << endl;
-        return false;
+        if (!tableCatalogue.isColumnFromTable(columnName, parsedQuery.groupRelationName))
+        {
+            cout << "SEMANTIC ERROR: Column doesn't exist in relation" << endl;
+            return false;
+        }
+    }
+
+    // Result columns are the grouping columns followed by the aggregates
+    unordered_set<string> resultColumnNames;
+    for (auto &columnName : parsedQuery.groupColumnNames)
+    {
+        if (!resultColumnNames.insert(columnName).second)
+        {
+            cout << "SEMANTIC ERROR: Column with name already exists" << endl;
+            return false;
+        }
+    }
+    for (auto &returnAggregate : parsedQuery.groupReturnAggregates)
+    {
+        if (!resultColumnNames.insert(getGroupResultColumnName(returnAggregate)).second)
+        {
+            cout << "SEMANTIC ERROR: Column with name already exists" << endl;
+            return false;
+        }
     }
     return true;
 }
 
+/**
+ * @brief Resolves the name of an aggregate function, already checked by the
+ * syntactic parser.
+ *
+ * @param aggregateFunctionName 
+ * @return AggregateFunction 
+ */
+AggregateFunction getAggregateFunction(string aggregateFunctionName)
+{
+    if (aggregateFunctionName == "SUM")
+        return AGGREGATE_SUM;
+    if (aggregateFunctionName == "MAX")
+        return AGGREGATE_MAX;
+    if (aggregateFunctionName == "MIN")
+        return AGGREGATE_MIN;
+    if (aggregateFunctionName == "AVG")
+        return AGGREGATE_AVG;
+    return AGGREGATE_COUNT;
+}
+
+/**
+ * @brief All the aggregates, of HAVING and of RETURN, are computed together in
+ * one pass over the relation.
+ *
+ * A relation already sorted on the grouping columns is grouped as it is.
+ * Otherwise the number of groups is estimated from the distinct values of the
+ * grouping columns. If they fit in memory after at most one round of
+ * partitioning, hash aggregation (see Table::hashGroupTable) takes a single
+ * pass, or two for the spilled rows, else a sorted copy of the relation is
+ * grouped instead.
+ *
+ */
 void executeGROUP()
 {
     logger.log("executeGROUP");
 
     string tempFileName = "$groupTemp_" + parsedQuery.groupRelationName;
     Table *table = tableCatalogue.getTable(parsedQuery.groupRelationName);
-    Table *tempTable = new Table(tempFileName);
-
-    tempTable->columns = table->columns;
-    tempTable->distinctValuesPerColumnCount = table->distinctValuesPerColumnCount;
-    tempTable->columnCount = table->columnCount;
-    tempTable->rowCount = table->rowCount;
-    tempTable->blockCount = table->blockCount;
-    tempTable->maxRowsPerBlock = table->maxRowsPerBlock;
-    tempTable->rowsPerBlockCount = table->rowsPerBlockCount;
-    tempTable->indexed = table->indexed;
-    tempTable->indexedColumn = table->indexedColumn;
-    tempTable->indexingStrategy = table->indexingStrategy;
-
-    Cursor cursor(parsedQuery.groupRelationName, 0);
-    for(int i = 0; i < table->blockCount; i++) {
-        vector<vector<int>> rows = cursor.getPage();
-        int nRows = table->rowsPerBlockCount[i];
-        bufferManager.writePage(tempFileName, i, rows, nRows);
-        
-        if(i + 1 < table->blockCount) cursor.nextPage(i + 1);
-    }
-
-    tableCatalogue.insertTable(tempTable);
-    
-    int groupColumnIndex = table->getColumnIndex(parsedQuery.groupColumnName);
-    int groupAggregateColumnIndex = table->getColumnIndex(parsedQuery.groupAggregateColumnName);
-    int groupReturnAggregateColumnIndex = table->getColumnIndex(parsedQuery.groupReturnAggregateColumnName);
 
-    tempTable->sortTable({groupColumnIndex}, {ASC});
+    vector<int> groupColumnIndices;
+    for (auto &groupColumnName : parsedQuery.groupColumnNames)
+        groupColumnIndices.push_back(table->getColumnIndex(groupColumnName));
 
-    //--------------------------------------------------
+    // The HAVING aggregate, if any, comes first
+    vector<GroupAggregate> aggregates;
+    if (parsedQuery.groupBinaryOperator != NO_BINOP_CLAUSE)
+    {
+        int columnIndex = (parsedQuery.groupAggregateColumnName == "*") ? -1 : table->getColumnIndex(parsedQuery.groupAggregateColumnName);
+        aggregates.push_back(GroupAggregate(getAggregateFunction(parsedQuery.groupAggregateFunction), columnIndex));
+    }
 
     Table *resultantTable = new Table(parsedQuery.groupResultRelationName);
-    resultantTable->columns = {parsedQuery.groupColumnName,  parsedQuery.groupReturnAggregateFunction + parsedQuery.groupReturnAggregateColumnName};
+    resultantTable->columns = parsedQuery.groupColumnNames;
+    for (auto &returnAggregate : parsedQuery.groupReturnAggregates)
+    {
+        int columnIndex = (returnAggregate.second == "*") ? -1 : table->getColumnIndex(returnAggregate.second);
+        aggregates.push_back(GroupAggregate(getAggregateFunction(returnAggregate.first), columnIndex));
+        resultantTable->columns.push_back(getGroupResultColumnName(returnAggregate));
+    }
     resultantTable->columnCount = resultantTable->columns.size();
     resultantTable->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * resultantTable->columnCount));
-    resultantTable->indexed = table->indexed;
-    resultantTable->indexedColumn = table->indexedColumn;
-    resultantTable->indexingStrategy = table->indexingStrategy;
 
-    resultantTable -> groupTable(tempTable, groupColumnIndex, parsedQuery.groupBinaryOperator, parsedQuery.groupAggregateColumnValue, parsedQuery.groupAggregateFunction, groupAggregateColumnIndex, parsedQuery.groupReturnAggregateFunction, groupReturnAggregateColumnIndex);
-    
-    tableCatalogue.insertTable(resultantTable);
-    tableCatalogue.deleteTable(tempTable->tableName);
+    vector<SortingStrategy> sortStrategyList(groupColumnIndices.size(), ASC);
+    Table *tempTable = table;
+    if (!table->isSortedOn(groupColumnIndices, sortStrategyList))
+    {
+        uint memoryPageCount = memoryFrames(2);
+        long double estimatedGroupCount = 1;
+        for (int groupColumnIndex : groupColumnIndices)
+        {
+            if (groupColumnIndex < table->distinctValuesPerColumnCount.size() && table->distinctValuesPerColumnCount[groupColumnIndex] > 0)
+                estimatedGroupCount *= table->distinctValuesPerColumnCount[groupColumnIndex];
+            else
+                estimatedGroupCount = table->rowCount;
+        }
+        estimatedGroupCount = min(estimatedGroupCount, (long double)table->rowCount);
+        // Groups that fit after one level of partitioning, with the frames
+        // split between groups and partition buffers as hashGroupPartition does
+        uint partitionCount = max(1u, memoryPageCount / 2);
+        long long int groupCapacity = (long long int)max(1u, memoryPageCount - partitionCount) * resultantTable->maxRowsPerBlock * (partitionCount + 1);
+        if (estimatedGroupCount <= groupCapacity)
+            tempTable = nullptr;
+        else
+        {
+            tempTable = table->createCopy(tempFileName, groupColumnIndices, sortStrategyList);
+            tempTable->sortTable(groupColumnIndices, sortStrategyList);
+        }
+    }
+
+    if (tempTable)
+    {
+        resultantTable->groupTable(tempTable, groupColumnIndices, aggregates, parsedQuery.groupBinaryOperator, parsedQuery.groupAggregateColumnValue);
+        for (int columnCounter = 0; columnCounter < groupColumnIndices.size(); columnCounter++)
+            resultantTable->sortOrder.emplace_back(columnCounter, ASC);
+        if (tempTable != table)
+            tableCatalogue.deleteTable(tempTable->tableName);
+    }
+    else
+        resultantTable->hashGroupTable(table, groupColumnIndices, aggregates, parsedQuery.groupBinaryOperator, parsedQuery.groupAggregateColumnValue);
 
+    if (resultantTable->rowCount > 0)
+        tableCatalogue.insertTable(resultantTable);
+    else
+    {
+        cout << "Empty Table" << endl;
+        resultantTable->unload();
+        delete resultantTable;
+    }
     return;
-}
\ No newline at end of file
+}
@@ -2,7 +2,7 @@
 /**
  * @brief 
  * SYNTAX: INDEX ON column_name FROM relation_name USING indexing_strategy
- * indexing_strategy: ASC | DESC | NOTHING
+ * indexing_strategy: BTREE | HASH | NOTHING
  */
 bool syntacticParseINDEX()
 {
@@ -54,5 +54,7 @@ bool semanticParseINDEX()
 void executeINDEX()
 {
     logger.log("executeINDEX");
+    Table *table = tableCatalogue.getTable(parsedQuery.indexRelationName);
+    table->buildIndex(parsedQuery.indexColumnName, parsedQuery.indexingStrategy);
     return;
 }
\ No newline at end of file
@@ -1,4 +1,35 @@
 #include "global.h"
+/**
+ * @brief 
+ * SYNTAX: R <- JOIN relation_name1, relation_name2, relation_name3 ON column_name1 == column_name2 AND column_name3 == column_name4
+ */
+bool syntacticParseMultiJOIN(int onPosition)
+{
+    logger.log("syntacticParseMultiJOIN");
+    int relationCount = onPosition - 3;
+    if (tokenizedQuery.size() != onPosition + 1 + 3 * (relationCount - 1) + (relationCount - 2))
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    parsedQuery.queryType = JOIN;
+    parsedQuery.joinResultRelationName = tokenizedQuery[0];
+    for (int relationCounter = 0; relationCounter < relationCount; relationCounter++)
+        parsedQuery.joinRelationNames.push_back(tokenizedQuery[3 + relationCounter]);
+    for (int conditionCounter = 0; conditionCounter < relationCount - 1; conditionCounter++)
+    {
+        int position = onPosition + 1 + 4 * conditionCounter;
+        if (tokenizedQuery[position + 1] != "==" || (conditionCounter > 0 && tokenizedQuery[position - 1] != "AND"))
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+        parsedQuery.joinColumnNamePairs.emplace_back(tokenizedQuery[position], tokenizedQuery[position + 2]);
+    }
+    parsedQuery.joinBinaryOperator = EQUAL;
+    return true;
+}
+
 /**
  * @brief 
  * SYNTAX: R <- JOIN relation_name1, relation_name2 ON column_name1 bin_op column_name2
@@ -6,6 +37,9 @@
 bool syntacticParseJOIN()
 {
     logger.log("syntacticParseJOIN");
+    int onPosition = find(tokenizedQuery.begin(), tokenizedQuery.end(), "ON") - tokenizedQuery.begin();
+    if (onPosition > 5 && onPosition < tokenizedQuery.size())
+        return syntacticParseMultiJOIN(onPosition);
     if (tokenizedQuery.size() != 9 || tokenizedQuery[5] != "ON")
     {
         cout << "SYNTAC ERROR" << endl;
@@ -39,6 +73,33 @@ bool syntacticParseJOIN()
     return true;
 }
 
+bool semanticParseMultiJOIN()
+{
+    logger.log("semanticParseMultiJOIN");
+
+    for (string relationName : parsedQuery.joinRelationNames)
+    {
+        if (!tableCatalogue.isTable(relationName))
+        {
+            cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
+            return false;
+        }
+    }
+
+    for (int conditionCounter = 0; conditionCounter < parsedQuery.joinColumnNamePairs.size(); conditionCounter++)
+    {
+        bool leftFound = false;
+        for (int relationCounter = 0; relationCounter <= conditionCounter; relationCounter++)
+            leftFound = leftFound || tableCatalogue.isColumnFromTable(parsedQuery.joinColumnNamePairs[conditionCounter].first, parsedQuery.joinRelationNames[relationCounter]);
+        if (!leftFound || !tableCatalogue.isColumnFromTable(parsedQuery.joinColumnNamePairs[conditionCounter].second, parsedQuery.joinRelationNames[conditionCounter + 1]))
+        {
+            cout << "SEMANTIC ERROR: Column doesn't exist in relation" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 bool semanticParseJOIN()
 {
     logger.log("semanticParseJOIN");
@@ -49,6 +110,9 @@ bool semanticParseJOIN()
         return false;
     }
 
+    if (!parsedQuery.joinRelationNames.empty())
+        return semanticParseMultiJOIN();
+
     if (!tableCatalogue.isTable(parsedQuery.joinFirstRelationName) || !tableCatalogue.isTable(parsedQuery.joinSecondRelationName))
     {
         cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
@@ -63,44 +127,175 @@ bool semanticParseJOIN()
     return true;
 }
 
-Table* createDeepCopyOfTable(string joinRelationName, string joinColumnName) {
+/**
+ * @brief Returns the relation sorted on the join column. A sorted copy is made
+ * unless the relation is already known to be sorted on it.
+ *
+ * @param joinRelationName 
+ * @param joinColumnName 
+ * @param tempFileName name of the copy
+ * @return Table* 
+ */
+Table* createDeepCopyOfTable(string joinRelationName, string joinColumnName, string tempFileName) {
 
-    string tempFileName = "$joinTemp_" + joinRelationName;
     Table *table = tableCatalogue.getTable(joinRelationName);
-    Table *tempTable = new Table(tempFileName);
-
-    tempTable->columns = table->columns;
-    tempTable->distinctValuesPerColumnCount = table->distinctValuesPerColumnCount;
-    tempTable->columnCount = table->columnCount;
-    tempTable->rowCount = table->rowCount;
-    tempTable->blockCount = table->blockCount;
-    tempTable->maxRowsPerBlock = table->maxRowsPerBlock;
-    tempTable->rowsPerBlockCount = table->rowsPerBlockCount;
-    tempTable->indexed = table->indexed;
-    tempTable->indexedColumn = table->indexedColumn;
-    tempTable->indexingStrategy = table->indexingStrategy;
-
-    Cursor cursor(joinRelationName, 0);
-    for(int i = 0; i < table->blockCount; i++) {
-        vector<vector<int>> rows = cursor.getPage();
-        int nRows = table->rowsPerBlockCount[i];
-        bufferManager.writePage(tempFileName, i, rows, nRows);
-        
-        if(i + 1 < table->blockCount) cursor.nextPage(i + 1);
-    }
-
-    tableCatalogue.insertTable(tempTable);
     int joinColumnIndex = table->getColumnIndex(joinColumnName);
+    if (table->isSortedOn({joinColumnIndex}, {ASC}))
+        return table;
+
+    Table *tempTable = table->createCopy(tempFileName, {joinColumnIndex}, {ASC});
     tempTable->sortTable({joinColumnIndex}, {ASC});
 
     return tempTable;
 }
+bool isIndexedOn(Table *table, string columnName)
+{
+    return table->indexed && table->indexedColumn == columnName;
+}
+
+/**
+ * @brief Number of index lookups needed to join the rows of table, that is the
+ * number of distinct values of the join column when it's known.
+ *
+ * @param table 
+ * @param columnIndex 
+ * @return long long int 
+ */
+long long int estimateProbeCount(Table *table, int columnIndex)
+{
+    if (columnIndex < table->distinctValuesPerColumnCount.size())
+        return min(table->rowCount, (long long int)table->distinctValuesPerColumnCount[columnIndex]);
+    return table->rowCount;
+}
+
+/**
+ * @brief Creates an empty relation whose columns are those of tables one after
+ * the other, as they are in a join result.
+ *
+ * @param tableName 
+ * @param tables 
+ * @return Table* 
+ */
+Table* createJoinResultTable(string tableName, vector<Table*> tables)
+{
+    Table *resultantTable = new Table(tableName);
+    for (Table *table : tables)
+        resultantTable->columns.insert(resultantTable->columns.end(), table->columns.begin(), table->columns.end());
+    resultantTable->columnCount = resultantTable->columns.size();
+    resultantTable->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * resultantTable->columnCount));
+    return resultantTable;
+}
+
+/**
+ * @brief Joins the relations of a multi-way JOIN left to right. As many of
+ * the following relations as fit in memory together are joined to the tuples
+ * so far in a single pipeline (see Table::multiJoinTable). Only when a relation
+ * doesn't fit next to the previous ones is an intermediate relation written
+ * out, and a relation too large to fit by itself is joined on its own with the
+ * hash join.
+ *
+ */
+void executeMultiJOIN()
+{
+    logger.log("executeMultiJOIN");
+
+    vector<Table*> tables;
+    for (string relationName : parsedQuery.joinRelationNames)
+        tables.push_back(tableCatalogue.getTable(relationName));
+
+    // Join columns as indices into the tuples joined so far and into the next
+    // relation
+    vector<pair<int, int>> joinColumnIndices;
+    for (int conditionCounter = 0; conditionCounter < parsedQuery.joinColumnNamePairs.size(); conditionCounter++)
+    {
+        int columnOffset = 0;
+        for (int relationCounter = 0; relationCounter <= conditionCounter; relationCounter++)
+        {
+            if (tables[relationCounter]->isColumn(parsedQuery.joinColumnNamePairs[conditionCounter].first))
+            {
+                columnOffset += tables[relationCounter]->getColumnIndex(parsedQuery.joinColumnNamePairs[conditionCounter].first);
+                break;
+            }
+            columnOffset += tables[relationCounter]->columnCount;
+        }
+        joinColumnIndices.emplace_back(columnOffset, tables[conditionCounter + 1]->getColumnIndex(parsedQuery.joinColumnNamePairs[conditionCounter].second));
+    }
+
+    uint memoryPageCount = memoryFrames(2);
+    Table *joinedTable = tables[0];
+    vector<Table*> joinedTables = {tables[0]};
+    uint nextRelation = 1;
+    while (nextRelation < tables.size())
+    {
+        uint lastRelation = nextRelation + 1;
+        uint pageCount = tables[nextRelation]->blockCount;
+        while (lastRelation < tables.size() && pageCount + tables[lastRelation]->blockCount <= memoryPageCount)
+            pageCount += tables[lastRelation++]->blockCount;
+
+        joinedTables.insert(joinedTables.end(), tables.begin() + nextRelation, tables.begin() + lastRelation);
+        string resultName = lastRelation == tables.size() ? parsedQuery.joinResultRelationName : "$multiJoin" + to_string(lastRelation) + "_" + parsedQuery.joinResultRelationName;
+        Table *resultantTable = createJoinResultTable(resultName, joinedTables);
+        tableCatalogue.insertTable(resultantTable);
+        if (pageCount <= memoryPageCount)
+        {
+            vector<Table*> stageTables = {joinedTable};
+            stageTables.insert(stageTables.end(), tables.begin() + nextRelation, tables.begin() + lastRelation);
+            resultantTable->multiJoinTable(stageTables, vector<pair<int, int>>(joinColumnIndices.begin() + nextRelation - 1, joinColumnIndices.begin() + lastRelation - 1));
+        }
+        else
+            resultantTable->hashJoinTable(joinedTable, tables[nextRelation], joinColumnIndices[nextRelation - 1].first, joinColumnIndices[nextRelation - 1].second);
+
+        if (joinedTable != tables[0])
+            tableCatalogue.deleteTable(joinedTable->tableName);
+        joinedTable = resultantTable;
+        nextRelation = lastRelation;
+    }
+}
+
 void executeJOIN()
 {
     logger.log("executeJOIN");
 
-    Table *tempTable1 = createDeepCopyOfTable(parsedQuery.joinFirstRelationName, parsedQuery.joinFirstColumnName);
-    Table *tempTable2 = createDeepCopyOfTable(parsedQuery.joinSecondRelationName, parsedQuery.joinSecondColumnName);
+    if (!parsedQuery.joinRelationNames.empty())
+    {
+        executeMultiJOIN();
+        return;
+    }
+
+    Table *table1 = tableCatalogue.getTable(parsedQuery.joinFirstRelationName);
+    Table *table2 = tableCatalogue.getTable(parsedQuery.joinSecondRelationName);
+    int firstColumnIndex = table1->getColumnIndex(parsedQuery.joinFirstColumnName);
+    int secondColumnIndex = table2->getColumnIndex(parsedQuery.joinSecondColumnName);
+    // An indexed relation is probed when the other side has fewer join keys
+    // than the indexed relation has pages. Otherwise equi-joins are hashed,
+    // unless both relations are already sorted on the join columns, in which
+    // case merging them needs no extra pass.
+    if (parsedQuery.joinBinaryOperator == EQUAL)
+    {
+        bool probeSecond = isIndexedOn(table2, parsedQuery.joinSecondColumnName) && estimateProbeCount(table1, firstColumnIndex) < table2->blockCount;
+        bool probeFirst = isIndexedOn(table1, parsedQuery.joinFirstColumnName) && estimateProbeCount(table2, secondColumnIndex) < table1->blockCount;
+        bool sorted = table1->isSortedOn({firstColumnIndex}, {ASC}) && table2->isSortedOn({secondColumnIndex}, {ASC});
+        if (probeSecond || probeFirst || !sorted)
+        {
+            Table *resultantTable = new Table(parsedQuery.joinResultRelationName);
+            resultantTable->columns = table1->columns;
+            resultantTable->columns.insert(resultantTable->columns.end(), table2->columns.begin(), table2->columns.end());
+            resultantTable->columnCount = resultantTable->columns.size();
+            resultantTable->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * resultantTable->columnCount));
+            if (probeSecond)
+                resultantTable->indexJoinTable(table1, table2, firstColumnIndex, true);
+            else if (probeFirst)
+                resultantTable->indexJoinTable(table2, table1, secondColumnIndex, false);
+            else
+                resultantTable->hashJoinTable(table1, table2, firstColumnIndex, secondColumnIndex);
+            tableCatalogue.insertTable(resultantTable);
+            return;
+        }
+    }
+
+    // Both copies get their own name, a relation may be joined with itself
+    Table *tempTable1 = createDeepCopyOfTable(parsedQuery.joinFirstRelationName, parsedQuery.joinFirstColumnName, "$joinTemp1_" + parsedQuery.joinFirstRelationName);
+    Table *tempTable2 = createDeepCopyOfTable(parsedQuery.joinSecondRelationName, parsedQuery.joinSecondColumnName, "$joinTemp2_" + parsedQuery.joinSecondRelationName);
 
     int joinFirstColumnIndex = tempTable1->getColumnIndex(parsedQuery.joinFirstColumnName);
     int joinSecondColumnIndex = tempTable2->getColumnIndex(parsedQuery.joinSecondColumnName);
@@ -120,9 +315,14 @@ void executeJOIN()
     resultantTable->columnCount = resultantTable->columns.size();
     resultantTable->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * resultantTable->columnCount));
 
-    resultantTable -> joinTable(tempTable1, tempTable2, joinFirstColumnIndex, joinSecondColumnIndex, parsedQuery.joinBinaryOperator);
+    if (parsedQuery.joinBinaryOperator == EQUAL)
+        resultantTable -> joinTable(tempTable1, tempTable2, joinFirstColumnIndex, joinSecondColumnIndex);
+    else
+        resultantTable->inequalityJoinTable(tempTable1, tempTable2, joinFirstColumnIndex, joinSecondColumnIndex, parsedQuery.joinBinaryOperator);
 
     tableCatalogue.insertTable(resultantTable);
-    tableCatalogue.deleteTable(tempTable1->tableName);
-    tableCatalogue.deleteTable(tempTable2->tableName);
+    if (tempTable1->tableName != parsedQuery.joinFirstRelationName)
+        tableCatalogue.deleteTable(tempTable1->tableName);
+    if (tempTable2->tableName != parsedQuery.joinSecondRelationName)
+        tableCatalogue.deleteTable(tempTable2->tableName);
 }
\ No newline at end of file
@@ -1,17 +1,28 @@
 #include "global.h"
 /**
  * @brief 
- * SYNTAX: R <- ORDER BY column_name ASC|DESC ON relation_name
+ * SYNTAX: R <- ORDER BY column_name ASC|DESC ON relation_name [LIMIT k]
  */
 bool syntacticParseORDER()
 {
     logger.log("syntacticParseORDER");
-    if (tokenizedQuery.size() != 8 || tokenizedQuery[3] != "BY" || tokenizedQuery[6] != "ON")
+    if ((tokenizedQuery.size() != 8 && tokenizedQuery.size() != 10) || tokenizedQuery[3] != "BY" || tokenizedQuery[6] != "ON")
     {
         cout << "SYNTAX ERROR" << endl;
         return false;
     }
 
+    if (tokenizedQuery.size() == 10)
+    {
+        regex limit("[1-9][0-9]{0,8}");
+        if (tokenizedQuery[8] != "LIMIT" || !regex_match(tokenizedQuery[9], limit))
+        {
+            cout << "SYNTAX ERROR" << endl;
+            return false;
+        }
+        parsedQuery.orderLimit = stoi(tokenizedQuery[9]);
+    }
+
     parsedQuery.queryType = ORDER;
     parsedQuery.orderResultRelationName = tokenizedQuery[0];
     parsedQuery.orderColumnName = tokenizedQuery[4];
@@ -60,33 +71,26 @@ void executeORDER()
     logger.log("executeORDER");
     
     Table *table = tableCatalogue.getTable(parsedQuery.orderRelationName);
-    Table *resultantTable = new Table(parsedQuery.orderResultRelationName);
-
-    resultantTable->columns = table->columns;
-    resultantTable->distinctValuesInColumns = table->distinctValuesInColumns;
-    resultantTable->distinctValuesPerColumnCount = table->distinctValuesPerColumnCount;
-    resultantTable->columnCount = table->columnCount;
-    resultantTable->rowCount = table->rowCount;
-    resultantTable->blockCount = table->blockCount;
-    resultantTable->maxRowsPerBlock = table->maxRowsPerBlock;
-    resultantTable->rowsPerBlockCount = table->rowsPerBlockCount;
-    resultantTable->indexed = table->indexed;
-    resultantTable->indexedColumn = table->indexedColumn;
-    resultantTable->indexingStrategy = table->indexingStrategy;
+    int columnIndex = table->getColumnIndex(parsedQuery.orderColumnName);
+    long long int memoryRowCount = (long long int)memoryFrames(2) * table->maxRowsPerBlock;
 
-    
-    Cursor cursor(parsedQuery.orderRelationName, 0);
-    for(int i = 0; i < table->blockCount; i++) {
-        vector<vector<int>> rows = cursor.getPage();
-        int nRows = table->rowsPerBlockCount[i];
-        bufferManager.writePage(parsedQuery.orderResultRelationName, i, rows, nRows);
-        
-        if(i + 1 < table->blockCount) cursor.nextPage(i + 1);
+    // With a LIMIT that fits in memory the top rows are picked in one scan,
+    // otherwise the whole relation is sorted and cut down to the limit
+    if (parsedQuery.orderLimit != -1 && (parsedQuery.orderLimit <= memoryRowCount || table->isSortedOn({columnIndex}, {parsedQuery.orderSortingStrategy})))
+    {
+        Table *resultantTable = new Table(parsedQuery.orderResultRelationName);
+        resultantTable->columns = table->columns;
+        resultantTable->columnCount = table->columnCount;
+        resultantTable->maxRowsPerBlock = table->maxRowsPerBlock;
+        resultantTable->topKTable(table, {columnIndex}, {parsedQuery.orderSortingStrategy}, parsedQuery.orderLimit);
+        tableCatalogue.insertTable(resultantTable);
+        return;
     }
 
-    tableCatalogue.insertTable(resultantTable);
-
-    int columnIndices = table->getColumnIndex(parsedQuery.orderColumnName);
-    resultantTable->sortTable({columnIndices}, {parsedQuery.orderSortingStrategy});
+    Table *resultantTable = table->createCopy(parsedQuery.orderResultRelationName, {columnIndex}, {parsedQuery.orderSortingStrategy});
+    resultantTable->distinctValuesInColumns = table->distinctValuesInColumns;
+    resultantTable->sortTable({columnIndex}, {parsedQuery.orderSortingStrategy});
+    if (parsedQuery.orderLimit != -1)
+        resultantTable->truncate(parsedQuery.orderLimit);
     return;
 }
\ No newline at end of file
@@ -72,6 +72,16 @@ void executePROJECTION()
         row = cursor.getNext();
     }
     resultantTable->blockify();
+
+    // The rows stay in order on the longest prefix of the sort columns that is
+    // projected
+    for (auto &sortColumn : table.sortOrder)
+    {
+        auto projectedColumn = find(columnIndices.begin(), columnIndices.end(), sortColumn.first);
+        if (projectedColumn == columnIndices.end())
+            break;
+        resultantTable->sortOrder.emplace_back(projectedColumn - columnIndices.begin(), sortColumn.second);
+    }
     tableCatalogue.insertTable(resultantTable);
     return;
 }
\ No newline at end of file
@@ -82,7 +82,7 @@ bool semanticParseSELECTION()
     return true;
 }
 
-bool evaluateBinOp(int value1, int value2, BinaryOperator binaryOperator)
+bool evaluateBinOp(long long int value1, long long int value2, BinaryOperator binaryOperator)
 {
     switch (binaryOperator)
     {
@@ -129,7 +129,11 @@ void executeSELECTION()
         row = cursor.getNext();
     }
     if(resultantTable->blockify())
+    {
+        // Filtering keeps the rows in order
+        resultantTable->sortOrder = table.sortOrder;
         tableCatalogue.insertTable(resultantTable);
+    }
     else{
         cout<<"Empty Table"<<endl;
         resultantTable->unload();
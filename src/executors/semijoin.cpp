@@ -0,0 +1,156 @@
+#include "global.h"
+/**
+ * @brief SEMIJOIN and ANTIJOIN share their syntax and most of their work, they
+ * only differ in whether the rows with a match or without one are kept.
+ *
+ * SYNTAX: R <- SEMIJOIN relation_name1, relation_name2 ON column_name1 == column_name2
+ * SYNTAX: R <- ANTIJOIN relation_name1, relation_name2 ON column_name1 == column_name2
+ */
+bool syntacticParseSemiJoinStatement(QueryType queryType)
+{
+    if (tokenizedQuery.size() != 9 || tokenizedQuery[5] != "ON" || tokenizedQuery[7] != "==")
+    {
+        cout << "SYNTAX ERROR" << endl;
+        return false;
+    }
+    parsedQuery.queryType = queryType;
+    parsedQuery.semiJoinResultRelationName = tokenizedQuery[0];
+    parsedQuery.semiJoinFirstRelationName = tokenizedQuery[3];
+    parsedQuery.semiJoinSecondRelationName = tokenizedQuery[4];
+    parsedQuery.semiJoinFirstColumnName = tokenizedQuery[6];
+    parsedQuery.semiJoinSecondColumnName = tokenizedQuery[8];
+    return true;
+}
+
+bool syntacticParseSEMIJOIN()
+{
+    logger.log("syntacticParseSEMIJOIN");
+    return syntacticParseSemiJoinStatement(SEMIJOIN);
+}
+
+bool syntacticParseANTIJOIN()
+{
+    logger.log("syntacticParseANTIJOIN");
+    return syntacticParseSemiJoinStatement(ANTIJOIN);
+}
+
+bool semanticParseSemiJoinStatement()
+{
+    if (tableCatalogue.isTable(parsedQuery.semiJoinResultRelationName))
+    {
+        cout << "SEMANTIC ERROR: Resultant relation already exists" << endl;
+        return false;
+    }
+
+    if (!tableCatalogue.isTable(parsedQuery.semiJoinFirstRelationName) || !tableCatalogue.isTable(parsedQuery.semiJoinSecondRelationName))
+    {
+        cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
+        return false;
+    }
+
+    if (!tableCatalogue.isColumnFromTable(parsedQuery.semiJoinFirstColumnName, parsedQuery.semiJoinFirstRelationName) || !tableCatalogue.isColumnFromTable(parsedQuery.semiJoinSecondColumnName, parsedQuery.semiJoinSecondRelationName))
+    {
+        cout << "SEMANTIC ERROR: Column doesn't exist in relation" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool semanticParseSEMIJOIN()
+{
+    logger.log("semanticParseSEMIJOIN");
+    return semanticParseSemiJoinStatement();
+}
+
+bool semanticParseANTIJOIN()
+{
+    logger.log("semanticParseANTIJOIN");
+    return semanticParseSemiJoinStatement();
+}
+
+/**
+ * @brief Returns the table sorted in ascending order on columnIndex, a sorted
+ * copy named copyTableName unless the table is already known to be sorted.
+ *
+ * @param table
+ * @param columnIndex
+ * @param copyTableName
+ * @return Table*
+ */
+Table* sortedOnColumn(Table *table, int columnIndex, string copyTableName)
+{
+    if (table->isSortedOn({columnIndex}, {ASC}))
+        return table;
+    Table *copyTable = table->createCopy(copyTableName, {columnIndex}, {ASC});
+    copyTable->sortTable({columnIndex}, {ASC});
+    return copyTable;
+}
+
+/**
+ * @brief Adds the result to the catalogue, unless it's empty, like SELECT.
+ *
+ * @param resultantTable
+ */
+void insertSemiJoinResult(Table *resultantTable)
+{
+    if (resultantTable->rowCount > 0)
+    {
+        tableCatalogue.insertTable(resultantTable);
+        return;
+    }
+    cout << "Empty Table" << endl;
+    resultantTable->unload();
+    delete resultantTable;
+}
+
+/**
+ * @brief The result holds the rows of the first relation, so it has its
+ * columns. The keys of the second relation are hashed when they fit in memory
+ * and the inputs aren't both sorted already, the result then keeps the order
+ * of the first relation. Otherwise both relations are merged on their sorted
+ * join columns.
+ *
+ * @param anti
+ */
+void executeSemiJoinStatement(bool anti)
+{
+    Table *table1 = tableCatalogue.getTable(parsedQuery.semiJoinFirstRelationName);
+    Table *table2 = tableCatalogue.getTable(parsedQuery.semiJoinSecondRelationName);
+    int firstColumnIndex = table1->getColumnIndex(parsedQuery.semiJoinFirstColumnName);
+    int secondColumnIndex = table2->getColumnIndex(parsedQuery.semiJoinSecondColumnName);
+
+    Table *resultantTable = new Table(parsedQuery.semiJoinResultRelationName);
+    resultantTable->columns = table1->columns;
+    resultantTable->columnCount = table1->columnCount;
+    resultantTable->maxRowsPerBlock = table1->maxRowsPerBlock;
+
+    bool sorted = table1->isSortedOn({firstColumnIndex}, {ASC}) && table2->isSortedOn({secondColumnIndex}, {ASC});
+    if (!sorted && resultantTable->hashSemiJoinTable(table1, table2, firstColumnIndex, secondColumnIndex, anti))
+    {
+        resultantTable->sortOrder = table1->sortOrder;
+        insertSemiJoinResult(resultantTable);
+        return;
+    }
+
+    Table *tempTable1 = sortedOnColumn(table1, firstColumnIndex, "$semiJoinTemp1_" + table1->tableName);
+    Table *tempTable2 = sortedOnColumn(table2, secondColumnIndex, "$semiJoinTemp2_" + table2->tableName);
+    resultantTable->mergeSemiJoinTable(tempTable1, tempTable2, firstColumnIndex, secondColumnIndex, anti);
+    resultantTable->sortOrder = tempTable1->sortOrder;
+    insertSemiJoinResult(resultantTable);
+    if (tempTable1 != table1)
+        tableCatalogue.deleteTable(tempTable1->tableName);
+    if (tempTable2 != table2)
+        tableCatalogue.deleteTable(tempTable2->tableName);
+}
+
+void executeSEMIJOIN()
+{
+    logger.log("executeSEMIJOIN");
+    executeSemiJoinStatement(false);
+}
+
+void executeANTIJOIN()
+{
+    logger.log("executeANTIJOIN");
+    executeSemiJoinStatement(true);
+}
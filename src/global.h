@@ -3,11 +3,14 @@
 extern float BLOCK_SIZE;
 extern uint BLOCK_COUNT;
 extern uint PRINT_COUNT;
+extern long double CROSS_WARNING_BYTES;
+extern uint BLOOM_FILTER_RATIO;
+extern uint THREAD_COUNT;
 extern vector<string> tokenizedQuery;
 extern ParsedQuery parsedQuery;
 extern TableCatalogue tableCatalogue;
 extern MatrixCatalogue matrixCatalogue;
 extern BufferManager bufferManager;
 
-extern unsigned int BLOCKS_READ;
-extern unsigned int BLOCKS_WRITTEN;
\ No newline at end of file
+extern atomic<unsigned int> BLOCKS_READ;
+extern atomic<unsigned int> BLOCKS_WRITTEN;
\ No newline at end of file
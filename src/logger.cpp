@@ -3,9 +3,143 @@
 Logger::Logger()
 {
     this->fout.open(this->logFile, ios::out);
+    this->slots.reset(new Slot[QUEUE_CAPACITY]);
+    for (size_t slotCounter = 0; slotCounter < QUEUE_CAPACITY; slotCounter++)
+        this->slots[slotCounter].sequence.store(slotCounter, memory_order_relaxed);
+    this->enqueuePosition.store(0, memory_order_relaxed);
+    this->minimumLevel.store(LOG_MIN_LEVEL, memory_order_relaxed);
+    this->running.store(true, memory_order_release);
+    this->writer = thread(&Logger::drain, this);
+}
+
+/**
+ * @brief Stops the writer thread after it has written out every message still
+ * in the ring buffer.
+ *
+ */
+Logger::~Logger()
+{
+    this->running.store(false, memory_order_release);
+    if (this->writer.joinable())
+        this->writer.join();
+    this->fout.flush();
+    this->fout.close();
+}
+
+/**
+ * @brief Checks if messages of the given level are currently being recorded.
+ * Used by the LOG_* macros so that disabled messages are never built.
+ *
+ * @param level
+ * @return true
+ * @return false
+ */
+bool Logger::isEnabled(LogLevel level)
+{
+    return level >= this->minimumLevel.load(memory_order_relaxed);
+}
+
+/**
+ * @brief Raises or lowers the runtime threshold. Levels below LOG_MIN_LEVEL
+ * stay compiled out regardless of this setting.
+ *
+ * @param level
+ */
+void Logger::setLevel(LogLevel level)
+{
+    this->minimumLevel.store(level, memory_order_relaxed);
 }
 
 void Logger::log(string logString)
 {
-    fout << logString << endl;
+    this->log(LEVEL_INFO, move(logString));
+}
+
+/**
+ * @brief Pushes a message into the ring buffer. Each slot carries a sequence
+ * number that tells producers whether it is free for the current lap, so
+ * concurrent producers only contend on a single compare-and-swap.
+ *
+ * @param level
+ * @param logString
+ */
+void Logger::log(LogLevel level, string logString)
+{
+    if (!this->isEnabled(level))
+        return;
+
+    Slot *slot;
+    size_t position = this->enqueuePosition.load(memory_order_relaxed);
+    while (true)
+    {
+        slot = &this->slots[position & (QUEUE_CAPACITY - 1)];
+        size_t sequence = slot->sequence.load(memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0)
+        {
+            if (this->enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            this_thread::yield();
+            position = this->enqueuePosition.load(memory_order_relaxed);
+        }
+        else
+            position = this->enqueuePosition.load(memory_order_relaxed);
+    }
+    slot->level = level;
+    slot->message = move(logString);
+    slot->sequence.store(position + 1, memory_order_release);
+}
+
+/**
+ * @brief Pops the oldest message from the ring buffer. Only the writer thread
+ * calls this function.
+ *
+ * @param level
+ * @param message
+ * @return true if a message was popped
+ * @return false if the buffer is empty
+ */
+bool Logger::dequeue(LogLevel &level, string &message)
+{
+    Slot *slot = &this->slots[this->dequeuePosition & (QUEUE_CAPACITY - 1)];
+    size_t sequence = slot->sequence.load(memory_order_acquire);
+    if (sequence != this->dequeuePosition + 1)
+        return false;
+    level = slot->level;
+    message = move(slot->message);
+    slot->sequence.store(this->dequeuePosition + QUEUE_CAPACITY, memory_order_release);
+    this->dequeuePosition++;
+    return true;
+}
+
+/**
+ * @brief Body of the writer thread. Messages are written without flushing;
+ * the file is flushed only once the buffer has been emptied.
+ *
+ */
+void Logger::drain()
+{
+    static const char *levelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+    LogLevel level;
+    string message;
+    while (true)
+    {
+        bool stopping = !this->running.load(memory_order_acquire);
+        bool pending = false;
+        while (this->dequeue(level, message))
+        {
+            if (level != LEVEL_INFO)
+                this->fout << "[" << levelNames[level] << "] ";
+            this->fout << message << '\n';
+            pending = true;
+        }
+        if (pending)
+            this->fout.flush();
+        if (stopping)
+            break;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
 }
@@ -1,19 +1,102 @@
 #include<iostream>
 #include<bits/stdc++.h>
-#include<sys/stat.h> 
+#include<sys/stat.h>
 #include<fstream>
 
 using namespace std;
 
+/**
+ * @brief Severity of a log message. Row level events (cursor movement, row
+ * reads and writes) are logged at LEVEL_TRACE, page level events at
+ * LEVEL_DEBUG and command level events at LEVEL_INFO.
+ *
+ */
+enum LogLevel
+{
+    LEVEL_TRACE,
+    LEVEL_DEBUG,
+    LEVEL_INFO,
+    LEVEL_WARN,
+    LEVEL_ERROR
+};
+
+/**
+ * @brief Compile-time threshold. Messages logged through the LOG_* macros
+ * below this level are removed by the preprocessor, so they cost nothing at
+ * runtime. Release builds define it as 2 (LEVEL_INFO) through the Makefile.
+ *
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * @brief The Logger hands messages to a background thread through a bounded
+ * lock-free ring buffer, so the caller never waits on the log file. The
+ * writer thread drains the buffer into the log file and only flushes when
+ * the buffer runs empty. If the buffer is full the caller yields until the
+ * writer catches up, no message is dropped.
+ *
+ */
 class Logger{
 
+    static const size_t QUEUE_CAPACITY = 1 << 13;
+
+    struct Slot
+    {
+        atomic<size_t> sequence;
+        LogLevel level;
+        string message;
+    };
+
     string logFile = "log";
     ofstream fout;
-    
+    unique_ptr<Slot[]> slots;
+    atomic<size_t> enqueuePosition;
+    size_t dequeuePosition = 0;
+    atomic<bool> running;
+    atomic<int> minimumLevel;
+    thread writer;
+
+    bool dequeue(LogLevel &level, string &message);
+    void drain();
+
     public:
 
     Logger();
+    ~Logger();
+    bool isEnabled(LogLevel level);
+    void setLevel(LogLevel level);
     void log(string logString);
+    void log(LogLevel level, string logString);
 };
 
-extern Logger logger;
\ No newline at end of file
+extern Logger logger;
+
+#define LOG_AT_LEVEL(level, message)          \
+    do                                        \
+    {                                         \
+        if (logger.isEnabled(level))          \
+            logger.log(level, message);       \
+    } while (0)
+
+#if LOG_MIN_LEVEL <= 0
+#define LOG_TRACE(message) LOG_AT_LEVEL(LEVEL_TRACE, message)
+#else
+#define LOG_TRACE(message) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+#define LOG_DEBUG(message) LOG_AT_LEVEL(LEVEL_DEBUG, message)
+#else
+#define LOG_DEBUG(message) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 2
+#define LOG_INFO(message) LOG_AT_LEVEL(LEVEL_INFO, message)
+#else
+#define LOG_INFO(message) ((void)0)
+#endif
+
+#define LOG_WARN(message) LOG_AT_LEVEL(LEVEL_WARN, message)
+#define LOG_ERROR(message) LOG_AT_LEVEL(LEVEL_ERROR, message)
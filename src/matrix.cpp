@@ -146,7 +146,7 @@ void Matrix::print()
 }
 
 void Matrix::getNextPage(Cursor *cursor) {
-    logger.log("Matrix::getNegetNextPagext");
+    LOG_DEBUG("Matrix::getNextPage");
     if (cursor->pageIndex < this->blockCount - 1) {
         cursor->nextPage(cursor->pageIndex + 1);
     }
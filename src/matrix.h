@@ -29,7 +29,7 @@ public:
 
     void writeRow(vector<int> row, ostream &fout, int columnsToWrite, bool isPermanent = false)
     {
-        logger.log("Table::printRow");
+        LOG_TRACE("Matrix::writeRow");
         for (int columnCounter = 0; columnCounter < columnsToWrite; columnCounter++)
         {
             if (columnCounter != 0){
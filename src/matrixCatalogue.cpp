@@ -16,7 +16,7 @@ void MatrixCatalogue::deleteMatrix(string matrixName)
 
 Matrix* MatrixCatalogue::getMatrix(string matrixName)
 {
-    logger.log("MatrixCatalogue::getMatrix"); 
+    LOG_DEBUG("MatrixCatalogue::getMatrix"); 
     Matrix* matrix = this->matrices[matrixName];
     return matrix;
 }
@@ -31,7 +31,7 @@ void MatrixCatalogue::renameMatrix(string curMatrixName, string newMatrixName)
 
 bool MatrixCatalogue::isMatrix(string matrixName)
 {
-    logger.log("MatrixCatalogue::isMatrix"); 
+    LOG_DEBUG("MatrixCatalogue::isMatrix"); 
     if (this->matrices.count(matrixName))
         return true;
     return false;
@@ -27,7 +27,7 @@ Page::Page()
  */
 Page::Page(string tableName, int pageIndex, bool isMatrix)
 {
-    logger.log("Page::Page");
+    LOG_DEBUG("Page::Page");
     this->tableName = tableName;
     this->pageIndex = pageIndex;
     this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
@@ -44,10 +44,10 @@ Page::Page(string tableName, int pageIndex, bool isMatrix)
         this->rows.assign(rowCount, row);
     }
     else{
-        Table table = *tableCatalogue.getTable(tableName);
-        this->rowCount = table.rowsPerBlockCount[pageIndex];   
-        this->columnCount = table.columnCount;
-        uint maxRowCount = table.maxRowsPerBlock;
+        Table *table = tableCatalogue.getTable(tableName);
+        this->rowCount = table->rowsPerBlockCount[pageIndex];   
+        this->columnCount = table->columnCount;
+        uint maxRowCount = table->maxRowsPerBlock;
         vector<int> row(columnCount, 0);
         this->rows.assign(maxRowCount, row);
     }
@@ -77,16 +77,29 @@ vector<vector<int>> Page::getRows(){
  */
 vector<int> Page::getRow(int rowIndex)
 {
-    logger.log("Page::getRow");
+    LOG_TRACE("Page::getRow");
     vector<int> result;
     if (rowIndex >= this->rowCount)
         return result;
     return this->rows[rowIndex];
 }
 
+/**
+ * @brief Get a reference to the row indexed by rowIndex, without copying it.
+ * The reference stays valid as long as the page object does. There is no
+ * bounds check, rowIndex has to be less than the number of rows in the page.
+ *
+ * @param rowIndex 
+ * @return const vector<int>& 
+ */
+const vector<int> &Page::getRowReference(int rowIndex)
+{
+    return this->rows[rowIndex];
+}
+
 Page::Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount)
 {
-    logger.log("Page::Page");
+    LOG_DEBUG("Page::Page");
     this->tableName = tableName;
     this->pageIndex = pageIndex;
     this->rows = rows;
@@ -101,17 +114,32 @@ Page::Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCou
  */
 void Page::writePage()
 {
-    logger.log("Page::writePage");
-    ofstream fout(this->pageName, ios::trunc);
-    for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++)
+    LOG_DEBUG("Page::writePage");
+    Page::writeRows(this->pageName, this->rows, this->rowCount);
+}
+
+/**
+ * @brief Writes the first rowCount rows to the page file pageName. This lets
+ * the buffer manager write a page straight from the caller's rows without
+ * copying them into a Page first.
+ * 
+ * @param pageName 
+ * @param rows 
+ * @param rowCount 
+ */
+void Page::writeRows(string pageName, const vector<vector<int>> &rows, int rowCount)
+{
+    ofstream fout(pageName, ios::trunc);
+    int columnCount = rowCount ? rows[0].size() : 0;
+    for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
     {
-        for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+        for (int columnCounter = 0; columnCounter < columnCount; columnCounter++)
         {
             if (columnCounter != 0)
                 fout << " ";
-            fout << this->rows[rowCounter][columnCounter];
+            fout << rows[rowCounter][columnCounter];
         }
-        fout << endl;
+        fout << '\n';
     }
     fout.close();
-}
+}
\ No newline at end of file
@@ -26,5 +26,7 @@ class Page{
     Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount);
     vector<vector<int>> getRows();
     vector<int> getRow(int rowIndex);
+    const vector<int> &getRowReference(int rowIndex);
     void writePage();
+    static void writeRows(string pageName, const vector<vector<int>> &rows, int rowCount);
 };
\ No newline at end of file
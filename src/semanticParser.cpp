@@ -26,6 +26,8 @@ bool semanticParse(){
         case COMPUTE: return semanticParseCOMPUTE();
         case ORDER: return semanticParseORDER();
         case GROUP: return semanticParseGROUP();
+        case SEMIJOIN: return semanticParseSEMIJOIN();
+        case ANTIJOIN: return semanticParseANTIJOIN();
         default: cout<<"SEMANTIC ERROR"<<endl;
     }
 
@@ -18,6 +18,8 @@ bool semanticParseSORT();
 bool semanticParseSOURCE();
 bool semanticParseORDER();
 bool semanticParseGROUP();
+bool semanticParseSEMIJOIN();
+bool semanticParseANTIJOIN();
 
 bool semanticParseLOAD_MATRIX();
 bool semanticParsePRINT_MATRIX();
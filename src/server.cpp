@@ -7,15 +7,24 @@ float BLOCK_SIZE = 1;
 // uint BLOCK_COUNT = 2;
 uint BLOCK_COUNT = 10;
 uint PRINT_COUNT = 20;
+// CROSS warns before starting when its output is estimated to reach this size
+long double CROSS_WARNING_BYTES = 1e12;
+// Hash joins filter the probe side through a Bloom filter on the build keys
+// when it has at least this many times as many pages as the build side
+uint BLOOM_FILTER_RATIO = 4;
+// Worker threads used by parallel operators, overridden by SIMPLERA_THREADS
+uint THREAD_COUNT = max(1u, thread::hardware_concurrency());
 Logger logger;
 vector<string> tokenizedQuery;
 ParsedQuery parsedQuery;
+// Catalogues unload their tables through the buffer manager when destroyed, so
+// it has to be constructed before (and destroyed after) them
+BufferManager bufferManager;
 TableCatalogue tableCatalogue;
 MatrixCatalogue matrixCatalogue;
-BufferManager bufferManager;
 
-unsigned int BLOCKS_READ = 0;
-unsigned int BLOCKS_WRITTEN = 0;
+atomic<unsigned int> BLOCKS_READ(0);
+atomic<unsigned int> BLOCKS_WRITTEN(0);
 
 void doCommand()
 {
@@ -30,6 +39,8 @@ int main(void)
 
     regex delim("[^\\s,]+");
     string command;
+    if (getenv("SIMPLERA_THREADS"))
+        THREAD_COUNT = max(1, atoi(getenv("SIMPLERA_THREADS")));
     system("rm -rf ../data/temp");
     system("mkdir ../data/temp");
 
@@ -67,6 +67,10 @@ bool syntacticParse()
             return syntacticParseORDER();
         else if (possibleQueryType == "GROUP")
             return syntacticParseGROUP();
+        else if (possibleQueryType == "SEMIJOIN")
+            return syntacticParseSEMIJOIN();
+        else if (possibleQueryType == "ANTIJOIN")
+            return syntacticParseANTIJOIN();
         // else if (possibleQueryType == "SORT")
         //     return syntacticParseSORT();
         else
@@ -108,6 +112,8 @@ void ParsedQuery::clear()
     this->joinSecondRelationName = "";
     this->joinFirstColumnName = "";
     this->joinSecondColumnName = "";
+    this->joinRelationNames.clear();
+    this->joinColumnNamePairs.clear();
 
     this->loadRelationName = "";
 
@@ -140,16 +146,22 @@ void ParsedQuery::clear()
     this->orderResultRelationName = "";
     this->orderRelationName = "";
     this->orderColumnName = "";
+    this->orderLimit = -1;
 
     this->groupResultRelationName = "";
     this->groupRelationName = "";
-    this->groupColumnName = "";
+    this->groupColumnNames.clear();
     this->groupBinaryOperator = NO_BINOP_CLAUSE;
     this->groupAggregateColumnValue = 0;
     this->groupAggregateFunction = "";
     this->groupAggregateColumnName = "";
-    this->groupReturnAggregateFunction = "";
-    this->groupReturnAggregateColumnName = "";
+    this->groupReturnAggregates.clear();
+
+    this->semiJoinResultRelationName = "";
+    this->semiJoinFirstRelationName = "";
+    this->semiJoinSecondRelationName = "";
+    this->semiJoinFirstColumnName = "";
+    this->semiJoinSecondColumnName = "";
 
     this->sourceFileName = "";
 }
@@ -28,6 +28,8 @@ enum QueryType
     COMPUTE,
     ORDER,
     GROUP,
+    SEMIJOIN,
+    ANTIJOIN,
     UNDETERMINED
 };
 
@@ -92,6 +94,8 @@ public:
     string joinSecondRelationName = "";
     string joinFirstColumnName = "";
     string joinSecondColumnName = "";
+    vector<string> joinRelationNames;
+    vector<pair<string, string>> joinColumnNamePairs;
 
     string loadRelationName = "";
     string printRelationName = "";
@@ -127,16 +131,22 @@ public:
     string orderResultRelationName = "";
     string orderRelationName = "";
     string orderColumnName = "";
+    int orderLimit = -1;
 
     string groupResultRelationName = "";
     string groupRelationName = "";
-    string groupColumnName = "";
+    vector<string> groupColumnNames;
     BinaryOperator groupBinaryOperator = NO_BINOP_CLAUSE;
     int groupAggregateColumnValue = 0;
     string groupAggregateFunction = "";
     string groupAggregateColumnName = "";
-    string groupReturnAggregateFunction = "";
-    string groupReturnAggregateColumnName = "";
+    vector<pair<string, string>> groupReturnAggregates;
+
+    string semiJoinResultRelationName = "";
+    string semiJoinFirstRelationName = "";
+    string semiJoinSecondRelationName = "";
+    string semiJoinFirstColumnName = "";
+    string semiJoinSecondColumnName = "";
 
     ParsedQuery();
     void clear();
@@ -159,6 +169,8 @@ bool syntacticParseSORT();
 bool syntacticParseSOURCE();
 bool syntacticParseORDER();
 bool syntacticParseGROUP();
+bool syntacticParseSEMIJOIN();
+bool syntacticParseANTIJOIN();
 
 bool syntacticParseLOAD_MATRIX();
 bool syntacticParsePRINT_MATRIX();
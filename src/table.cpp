@@ -205,6 +205,8 @@ void Table::renameColumn(string fromColumnName, string toColumnName)
         if (columns[columnCounter] == fromColumnName)
         {
             columns[columnCounter] = toColumnName;
+            if (this->indexed && this->indexedColumn == fromColumnName)
+                this->indexedColumn = toColumnName;
             break;
         }
     }
@@ -246,7 +248,7 @@ void Table::print()
  */
 void Table::getNextPage(Cursor *cursor)
 {
-    logger.log("Table::getNext");
+    LOG_DEBUG("Table::getNextPage");
 
         if (cursor->pageIndex < this->blockCount - 1)
         {
@@ -337,405 +339,3057 @@ int Table::getColumnIndex(string columnName)
 }
 
 
+/**
+ * @brief Compares two rows on the sort columns. Returns true if row a has to
+ * be placed before row b.
+ *
+ * @param a 
+ * @param b 
+ * @return true 
+ * @return false 
+ */
+bool RowComparator::operator()(const vector<int> &a, const vector<int> &b) const
+{
+    for (int columnCounter = 0; columnCounter < this->columnIndices.size(); columnCounter++)
+    {
+        int columnIndex = this->columnIndices[columnCounter];
+        if (a[columnIndex] == b[columnIndex])
+            continue;
+        if (this->sortStrategyList[columnCounter] == ASC)
+            return a[columnIndex] < b[columnIndex];
+        return a[columnIndex] > b[columnIndex];
+    }
+    return false;
+}
+
+/**
+ * @brief Checks if the sort key fits in a normalized 64 bit key, that is if
+ * it's made of at most two columns.
+ *
+ * @return true 
+ * @return false 
+ */
+bool RowComparator::hasNormalizedKey() const
+{
+    return this->columnIndices.size() <= 2;
+}
+
+/**
+ * @brief Encodes the sort columns of row so that comparing the encoded keys as
+ * unsigned integers gives the same order as operator(). The sign bit of every
+ * value is flipped so that negative values come first, DESC columns are
+ * inverted and the first sort column ends up in the most significant bits.
+ *
+ * @param row 
+ * @return unsigned long long 
+ */
+unsigned long long RowComparator::normalizedKey(const vector<int> &row) const
+{
+    unsigned long long key = 0;
+    for (int columnCounter = 0; columnCounter < this->columnIndices.size(); columnCounter++)
+    {
+        uint32_t word = (uint32_t)row[this->columnIndices[columnCounter]] ^ 0x80000000u;
+        if (this->sortStrategyList[columnCounter] == DESC)
+            word = ~word;
+        key = (key << 32) | word;
+    }
+    return key;
+}
+
+/**
+ * @brief Stable LSD radix sort of (normalized key, row index) pairs, one byte
+ * of the key per pass. A pass is skipped when every key has the same byte in
+ * that position, so single column keys take at most four passes.
+ *
+ * @param keys 
+ */
+void radixSortKeys(vector<pair<unsigned long long, uint>> &keys)
+{
+    vector<pair<unsigned long long, uint>> sortedKeys(keys.size());
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t bucketOffsets[257] = {0};
+        for (auto &key : keys)
+            bucketOffsets[((key.first >> shift) & 0xff) + 1]++;
+        if (*max_element(bucketOffsets + 1, bucketOffsets + 257) == keys.size())
+            continue;
+        for (int bucket = 1; bucket < 257; bucket++)
+            bucketOffsets[bucket] += bucketOffsets[bucket - 1];
+        for (auto &key : keys)
+            sortedKeys[bucketOffsets[(key.first >> shift) & 0xff]++] = key;
+        keys.swap(sortedKeys);
+    }
+}
+
+/**
+ * @brief Creates an empty table with the same schema as this table and adds
+ * it to the tableCatalogue. The external sort writes its runs to such tables
+ * so that they can be read back through cursors.
+ *
+ * @param runTableName 
+ * @return Table* 
+ */
+Table* Table::createRunTable(string runTableName)
+{
+    logger.log("Table::createRunTable");
+    Table *runTable = new Table(runTableName);
+    runTable->columns = this->columns;
+    runTable->columnCount = this->columnCount;
+    runTable->maxRowsPerBlock = this->maxRowsPerBlock;
+    tableCatalogue.insertTable(runTable);
+    return runTable;
+}
+
+/**
+ * @brief Writes the first rowCount rows as the page indicated by pageIndex and
+ * updates the block statistics of the table accordingly.
+ *
+ * @param pageIndex 
+ * @param rows 
+ * @param rowCount 
+ */
+void Table::writePage(uint pageIndex, const vector<vector<int>> &rows, uint rowCount)
+{
+    bufferManager.writePage(this->tableName, pageIndex, rows, rowCount);
+    if (this->rowsPerBlockCount.size() <= pageIndex)
+        this->rowsPerBlockCount.resize(pageIndex + 1, 0);
+    this->rowsPerBlockCount[pageIndex] = rowCount;
+    if (this->blockCount <= pageIndex)
+        this->blockCount = pageIndex + 1;
+}
+
+/**
+ * @brief Appends the pages of output relations written by parallel tasks to
+ * this table, sharing their page files rather than copying them (see
+ * BufferManager::sharePage), and merges their statistics. The output relations
+ * are deleted afterwards.
+ *
+ * @param outputTables 
+ */
+void Table::appendOutputTables(const vector<Table*> &outputTables)
+{
+    logger.log("Table::appendOutputTables");
+    for (Table *outputTable : outputTables)
+    {
+        for (uint pageCounter = 0; pageCounter < outputTable->blockCount; pageCounter++)
+        {
+            if (!bufferManager.sharePage(outputTable->tableName, pageCounter, this->tableName, this->blockCount))
+            {
+                Page page = bufferManager.getPage(outputTable->tableName, pageCounter, false);
+                vector<vector<int>> rows;
+                for (uint rowCounter = 0; rowCounter < outputTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+                    rows.push_back(page.getRowReference(rowCounter));
+                bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+            }
+            this->rowsPerBlockCount.emplace_back(outputTable->rowsPerBlockCount[pageCounter]);
+            this->blockCount++;
+        }
+        this->rowCount += outputTable->rowCount;
+        for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+            this->distinctValuesInColumns[columnCounter].insert(outputTable->distinctValuesInColumns[columnCounter].begin(), outputTable->distinctValuesInColumns[columnCounter].end());
+        tableCatalogue.deleteTable(outputTable->tableName);
+    }
+    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+        this->distinctValuesPerColumnCount[columnCounter] = this->distinctValuesInColumns[columnCounter].size();
+}
+
+/**
+ * @brief Same as writePage, but the page file is written on a separate thread.
+ * The block statistics are updated right away by the calling thread. The
+ * caller must leave rows untouched until the returned future is ready.
+ *
+ * @param pageIndex 
+ * @param rows 
+ * @param rowCount 
+ * @return future<void> 
+ */
+future<void> Table::writePageAsync(uint pageIndex, const vector<vector<int>> &rows, uint rowCount)
+{
+    if (this->rowsPerBlockCount.size() <= pageIndex)
+        this->rowsPerBlockCount.resize(pageIndex + 1, 0);
+    this->rowsPerBlockCount[pageIndex] = rowCount;
+    if (this->blockCount <= pageIndex)
+        this->blockCount = pageIndex + 1;
+    return bufferManager.writePageAsync(this->tableName, pageIndex, rows, rowCount);
+}
+
+/**
+ * @brief Makes room for pageCount pages in the block statistics up front.
+ * Threads can then write disjoint pages of the table through writePage without
+ * resizing rowsPerBlockCount under each other.
+ *
+ * @param pageCount 
+ */
+void Table::reservePages(uint pageCount)
+{
+    if (this->rowsPerBlockCount.size() < pageCount)
+        this->rowsPerBlockCount.resize(pageCount, 0);
+    this->blockCount = max(this->blockCount, pageCount);
+}
+
+/**
+ * @brief Run generation phase of the external sort. Only the pages in
+ * [firstPageIndex, lastPageIndex) are read, so that several threads can each
+ * generate runs from their own share of the table. Rows are buffered in
+ * memoryPageCount frames, the caller's share of the buffer pool less the
+ * input and output frames. Every run starts on a fresh page of runTable.
+ *
+ * Keys that fit in a normalized 64 bit key are radix sorted, wider keys fall
+ * back to replacement selection, which compares rows column by column.
+ *
+ * @param runTable 
+ * @param firstPageIndex 
+ * @param lastPageIndex 
+ * @param memoryPageCount 
+ * @param comparator 
+ * @return vector<SortRun> 
+ */
+vector<SortRun> Table::generateSortedRuns(Table *runTable, uint firstPageIndex, uint lastPageIndex, uint memoryPageCount, const RowComparator &comparator)
+{
+    logger.log("Table::generateSortedRuns");
+    if (comparator.hasNormalizedKey())
+        return this->generateRunsByRadixSort(runTable, firstPageIndex, lastPageIndex, memoryPageCount, comparator);
+    return this->generateRunsByReplacementSelection(runTable, firstPageIndex, lastPageIndex, memoryPageCount, comparator);
+}
+
+/**
+ * @brief Fills memoryPageCount frames with rows, radix sorts their (normalized
+ * key, row index) pairs and writes the rows out in key order as one run. The rows themselves are never moved while sorting,
+ * and the row buffers are reused from run to run.
+ *
+ * @param runTable 
+ * @param firstPageIndex 
+ * @param lastPageIndex 
+ * @param memoryPageCount 
+ * @param comparator 
+ * @return vector<SortRun> 
+ */
+vector<SortRun> Table::generateRunsByRadixSort(Table *runTable, uint firstPageIndex, uint lastPageIndex, uint memoryPageCount, const RowComparator &comparator)
+{
+    logger.log("Table::generateRunsByRadixSort");
+
+    uint runCapacity = memoryPageCount * this->maxRowsPerBlock;
+    vector<vector<int>> memoryRows(runCapacity);
+    vector<pair<unsigned long long, uint>> keys;
+    keys.reserve(runCapacity);
+
+    vector<SortRun> runs;
+    uint pageIndex = 0;
+    vector<vector<int>> rows(this->maxRowsPerBlock);
+    auto writeRun = [&]() {
+        radixSortKeys(keys);
+        SortRun run = {runTable, pageIndex, 0, (long long int)keys.size()};
+        for (uint keyCounter = 0; keyCounter < keys.size(); keyCounter += this->maxRowsPerBlock)
+        {
+            uint rowCount = min((size_t)this->maxRowsPerBlock, keys.size() - keyCounter);
+            for (uint rowCounter = 0; rowCounter < rowCount; rowCounter++)
+                rows[rowCounter].swap(memoryRows[keys[keyCounter + rowCounter].second]);
+            run.fenceRows.push_back(rows[0]);
+            runTable->writePage(pageIndex++, rows, rowCount);
+            run.pageCount++;
+        }
+        runs.push_back(run);
+        keys.clear();
+    };
+
+    for (uint pageCounter = firstPageIndex; pageCounter < lastPageIndex; pageCounter++)
+    {
+        Page page = bufferManager.getPage(this->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < this->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            uint rowIndex = keys.size();
+            memoryRows[rowIndex] = page.getRowReference(rowCounter);
+            keys.push_back({comparator.normalizedKey(memoryRows[rowIndex]), rowIndex});
+            if (keys.size() == runCapacity)
+                writeRun();
+        }
+    }
+    if (!keys.empty())
+        writeRun();
+    return runs;
+}
+
+/**
+ * @brief Replacement selection: memoryPageCount frames hold a heap of rows, and
+ * a row read from the input joins the current run as long as it doesn't sort
+ * before the last row written out. On random input the runs are about twice
+ * as long as the memory available to the heap.
+ *
+ * @param runTable 
+ * @param firstPageIndex 
+ * @param lastPageIndex 
+ * @param memoryPageCount 
+ * @param comparator 
+ * @return vector<SortRun> 
+ */
+vector<SortRun> Table::generateRunsByReplacementSelection(Table *runTable, uint firstPageIndex, uint lastPageIndex, uint memoryPageCount, const RowComparator &comparator)
+{
+    logger.log("Table::generateRunsByReplacementSelection");
+
+    auto heapComparator = [&comparator](const pair<int, vector<int>> &a, const pair<int, vector<int>> &b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+        return comparator(b.second, a.second);
+    };
+    priority_queue<pair<int, vector<int>>, vector<pair<int, vector<int>>>, decltype(heapComparator)> heap(heapComparator);
+
+    long long int rowsToRead = 0;
+    for (uint pageCounter = firstPageIndex; pageCounter < lastPageIndex; pageCounter++)
+        rowsToRead += this->rowsPerBlockCount[pageCounter];
+
+    Cursor cursor(this->tableName, firstPageIndex);
+    auto readRow = [&cursor, &rowsToRead]() {
+        if (rowsToRead == 0)
+            return vector<int>();
+        rowsToRead--;
+        return cursor.getNext();
+    };
+
+    uint heapCapacity = memoryPageCount * this->maxRowsPerBlock;
+    vector<int> row = readRow();
+    while (!row.empty() && heap.size() < heapCapacity)
+    {
+        heap.push({0, row});
+        row = readRow();
+    }
+
+    vector<SortRun> runs;
+    SortRun run = {runTable, 0, 0, 0};
+    int currentRun = 0;
+    uint pageIndex = 0;
+    vector<vector<int>> rows;
+    auto flushPage = [&]() {
+        run.fenceRows.push_back(rows.front());
+        runTable->writePage(pageIndex++, rows, rows.size());
+        run.pageCount++;
+        rows.clear();
+    };
+    while (!heap.empty())
+    {
+        pair<int, vector<int>> top = heap.top();
+        heap.pop();
+
+        if (top.first != currentRun)
+        {
+            if (!rows.empty())
+                flushPage();
+            runs.push_back(run);
+            run = {runTable, pageIndex, 0, 0};
+            currentRun = top.first;
+        }
+
+        if (!row.empty())
+        {
+            heap.push({comparator(row, top.second) ? currentRun + 1 : currentRun, row});
+            row = readRow();
+        }
+
+        rows.push_back(move(top.second));
+        run.rowCount++;
+        if (rows.size() == this->maxRowsPerBlock)
+            flushPage();
+    }
+    if (!rows.empty())
+        flushPage();
+    runs.push_back(run);
+    return runs;
+}
+
+/**
+ * @brief Reads a sorted run one row at a time without copying rows. The page
+ * being read is held by the cursor, so the reference returned by currentRow()
+ * stays valid until the reader moves past that row. The next page of the run
+ * can be prefetched while the current one is being read.
+ *
+ */
+struct RunReader
+{
+    Cursor cursor;
+    Table *table;
+    long long int rowsRemaining;
+    future<Page> prefetchedPage;
+
+    RunReader(const SortRun &run) : cursor(run.table->tableName, run.firstPage), table(run.table), rowsRemaining(run.rowCount)
+    {
+        this->cursor.pagePointer = run.firstRow;
+    }
+
+    RunReader(RunReader &&) = default;
+
+    // A prefetch still queued must not outlive the reader and its run table
+    ~RunReader()
+    {
+        if (this->prefetchedPage.valid())
+            this->prefetchedPage.wait();
+    }
+
+    const vector<int> &currentRow()
+    {
+        return this->cursor.page.getRowReference(this->cursor.pagePointer);
+    }
+
+    uint rowsLeftInPage()
+    {
+        return this->table->rowsPerBlockCount[this->cursor.pageIndex] - this->cursor.pagePointer;
+    }
+
+    bool hasNextPage()
+    {
+        return this->rowsRemaining > this->rowsLeftInPage();
+    }
+
+    /**
+     * @brief The last row of the run in the page being read. The run whose
+     * last row sorts first is the next one to run out of rows in its page.
+     *
+     * @return const vector<int>& 
+     */
+    const vector<int> &lastRowInPage()
+    {
+        return this->cursor.page.getRowReference(this->cursor.pagePointer + min((long long int)this->rowsLeftInPage(), this->rowsRemaining) - 1);
+    }
+
+    void prefetchNextPage()
+    {
+        if (!this->prefetchedPage.valid())
+            this->prefetchedPage = bufferManager.prefetchPage(this->table->tableName, this->cursor.pageIndex + 1, false);
+    }
+
+    /**
+     * @brief Moves past the current row.
+     *
+     * @return true if the reader moved on to the next page of the run
+     * @return false 
+     */
+    bool advance()
+    {
+        this->rowsRemaining--;
+        this->cursor.pagePointer++;
+        if (this->rowsRemaining == 0 || this->cursor.pagePointer < this->table->rowsPerBlockCount[this->cursor.pageIndex])
+            return false;
+        if (this->prefetchedPage.valid())
+        {
+            this->cursor.page = this->prefetchedPage.get();
+            this->cursor.pageIndex++;
+            this->cursor.pagePointer = 0;
+        }
+        else
+            this->cursor.nextPage(this->cursor.pageIndex + 1);
+        return true;
+    }
+};
+
+/**
+ * @brief Merges runs into a single run written to this table starting at page
+ * firstPageIndex. The runs may be stored in different tables and may start in
+ * the middle of a page (see SortRun::firstRow).
+ *
+ * The runs are merged with a tournament (loser) tree: tree[0] holds the run
+ * whose current row is the smallest and every other node holds the run that
+ * lost the match played there. After the winning row is written out only the
+ * matches on the path from the winner's leaf to the root are replayed, which
+ * takes about log2(k) comparisons for k runs. Rows are compared in place in
+ * the input pages and copied once, into the output page buffer, whose rows are
+ * reused from page to page.
+ *
+ * Reads and writes overlap with merging. One input frame is used for
+ * forecasting: whenever it is free, the next page of the run whose current
+ * page ends with the smallest row, which is the run that will need a new page
+ * first, is prefetched into it. The output is double buffered, a full page is
+ * written out on a separate thread while the next one fills.
+ *
+ * @param runs 
+ * @param firstPageIndex 
+ * @param comparator 
+ * @return SortRun the merged run
+ */
+SortRun Table::mergeSortedRuns(vector<SortRun> runs, uint firstPageIndex, const RowComparator &comparator)
+{
+    logger.log("Table::mergeSortedRuns");
+
+    vector<RunReader> readers;
+    for (auto &run : runs)
+        if (run.rowCount > 0)
+            readers.emplace_back(run);
+
+    SortRun mergedRun = {this, firstPageIndex, 0, 0};
+    int readerCount = readers.size();
+    if (readerCount == 0)
+        return mergedRun;
+
+    // With a normalized key the current key of every run is cached, so that
+    // matches compare two integers instead of two rows
+    bool useNormalizedKeys = comparator.hasNormalizedKey();
+    vector<unsigned long long> currentKeys(readerCount, 0);
+    if (useNormalizedKeys)
+        for (int readerCounter = 0; readerCounter < readerCount; readerCounter++)
+            currentKeys[readerCounter] = comparator.normalizedKey(readers[readerCounter].currentRow());
+
+    // Run a beats run b if it still has rows and its current row doesn't sort after b's
+    auto beats = [&](int a, int b) {
+        if (readers[a].rowsRemaining == 0)
+            return false;
+        if (readers[b].rowsRemaining == 0)
+            return true;
+        if (useNormalizedKeys)
+            return currentKeys[a] <= currentKeys[b];
+        return !comparator(readers[b].currentRow(), readers[a].currentRow());
+    };
+
+    // Leaves are the nodes readerCount ... 2 * readerCount - 1, leaf
+    // readerCount + i standing for run i
+    vector<int> tree(readerCount, 0);
+    function<int(int)> playMatches = [&](int node) {
+        if (node >= readerCount)
+            return node - readerCount;
+        int winner = playMatches(2 * node);
+        int challenger = playMatches(2 * node + 1);
+        if (beats(challenger, winner))
+            swap(winner, challenger);
+        tree[node] = challenger;
+        return winner;
+    };
+    tree[0] = (readerCount == 1) ? 0 : playMatches(1);
+
+    int prefetchingReader = -1;
+    auto forecast = [&]() {
+        prefetchingReader = -1;
+        for (int readerCounter = 0; readerCounter < readerCount; readerCounter++)
+            if (readers[readerCounter].hasNextPage() && (prefetchingReader == -1 || comparator(readers[readerCounter].lastRowInPage(), readers[prefetchingReader].lastRowInPage())))
+                prefetchingReader = readerCounter;
+        if (prefetchingReader != -1)
+            readers[prefetchingReader].prefetchNextPage();
+    };
+    forecast();
+
+    vector<vector<int>> rows(this->maxRowsPerBlock), writtenRows(this->maxRowsPerBlock);
+    future<void> pendingWrite;
+    uint rowCount = 0;
+    auto flushPage = [&]() {
+        mergedRun.fenceRows.push_back(rows[0]);
+        if (pendingWrite.valid())
+            pendingWrite.get();
+        rows.swap(writtenRows);
+        pendingWrite = this->writePageAsync(firstPageIndex + mergedRun.pageCount++, writtenRows, rowCount);
+        rowCount = 0;
+    };
+    while (readers[tree[0]].rowsRemaining > 0)
+    {
+        int winner = tree[0];
+        rows[rowCount++] = readers[winner].currentRow();
+        mergedRun.rowCount++;
+        if (rowCount == this->maxRowsPerBlock)
+            flushPage();
+
+        if (readers[winner].advance() && winner == prefetchingReader)
+            forecast();
+        if (useNormalizedKeys && readers[winner].rowsRemaining > 0)
+            currentKeys[winner] = comparator.normalizedKey(readers[winner].currentRow());
+        for (int node = (winner + readerCount) / 2; node >= 1; node /= 2)
+            if (beats(tree[node], winner))
+                swap(tree[node], winner);
+        tree[0] = winner;
+    }
+    if (rowCount > 0)
+        flushPage();
+    if (pendingWrite.valid())
+        pendingWrite.get();
+    return mergedRun;
+}
+
+/**
+ * @brief Finds the offset of the first row of run that doesn't sort before
+ * row. The fence rows narrow the search down to a single page, which is the
+ * only page read.
+ *
+ * @param run 
+ * @param row 
+ * @param comparator 
+ * @return long long int 
+ */
+long long int Table::findRowInRun(const SortRun &run, const vector<int> &row, const RowComparator &comparator)
+{
+    LOG_DEBUG("Table::findRowInRun");
+    uint fenceIndex = lower_bound(run.fenceRows.begin(), run.fenceRows.end(), row, comparator) - run.fenceRows.begin();
+    if (fenceIndex == 0)
+        return 0;
+
+    long long int rowOffset = 0;
+    for (uint pageCounter = 0; pageCounter < fenceIndex - 1; pageCounter++)
+        rowOffset += run.table->rowsPerBlockCount[run.firstPage + pageCounter];
+
+    uint pageIndex = run.firstPage + fenceIndex - 1;
+    Page page = bufferManager.getPage(run.table->tableName, pageIndex, false);
+    uint pageRowCount = run.table->rowsPerBlockCount[pageIndex];
+    uint rowCounter = 0;
+    while (rowCounter < pageRowCount && comparator(page.getRow(rowCounter), row))
+        rowCounter++;
+    return rowOffset + rowCounter;
+}
+
+/**
+ * @brief Returns the part of run made of its rows [firstRowOffset,
+ * lastRowOffset).
+ *
+ * @param run 
+ * @param firstRowOffset 
+ * @param lastRowOffset 
+ * @return SortRun 
+ */
+SortRun Table::sliceSortRun(const SortRun &run, long long int firstRowOffset, long long int lastRowOffset)
+{
+    SortRun slice = {run.table, run.firstPage, 0, lastRowOffset - firstRowOffset};
+    long long int rowOffset = firstRowOffset;
+    while (rowOffset >= run.table->rowsPerBlockCount[slice.firstPage] && slice.firstPage + 1 < run.firstPage + run.pageCount)
+        rowOffset -= run.table->rowsPerBlockCount[slice.firstPage++];
+    slice.firstRow = rowOffset;
+
+    long long int rowsLeft = slice.rowCount + slice.firstRow;
+    for (uint pageIndex = slice.firstPage; rowsLeft > 0; pageIndex++)
+    {
+        rowsLeft -= run.table->rowsPerBlockCount[pageIndex];
+        slice.pageCount++;
+    }
+    return slice;
+}
+
+/**
+ * @brief Final merge pass split across partitionCount threads. Splitters are
+ * taken at even intervals from the sorted fence rows (the first row of every
+ * page) of all runs, so each partition covers about the same number of pages.
+ * Each splitter is located in every run and partition p merges, from every
+ * run, the rows between splitters p - 1 and p. The number of rows in a
+ * partition is known before merging, so each partition writes its own range
+ * of pages of this table; only the last page of a partition may be partly
+ * filled. Each partition needs as many frames as a merge of all runs (see
+ * mergeSortedRuns), the caller makes sure partitionCount of them fit.
+ *
+ * @param runs 
+ * @param partitionCount 
+ * @param comparator 
+ */
+void Table::partitionedMergeSortedRuns(vector<SortRun> runs, uint partitionCount, const RowComparator &comparator)
+{
+    logger.log("Table::partitionedMergeSortedRuns");
+
+    vector<vector<int>> fenceRows;
+    for (auto &run : runs)
+        fenceRows.insert(fenceRows.end(), run.fenceRows.begin(), run.fenceRows.end());
+    sort(fenceRows.begin(), fenceRows.end(), comparator);
+
+    vector<vector<long long int>> boundaries(partitionCount + 1, vector<long long int>(runs.size(), 0));
+    for (int runCounter = 0; runCounter < runs.size(); runCounter++)
+        boundaries[partitionCount][runCounter] = runs[runCounter].rowCount;
+    for (uint partitionCounter = 1; partitionCounter < partitionCount; partitionCounter++)
+    {
+        vector<int> &splitter = fenceRows[fenceRows.size() * partitionCounter / partitionCount];
+        for (int runCounter = 0; runCounter < runs.size(); runCounter++)
+            boundaries[partitionCounter][runCounter] = this->findRowInRun(runs[runCounter], splitter, comparator);
+    }
+
+    vector<vector<SortRun>> partitionRuns(partitionCount);
+    vector<uint> firstPageIndices(partitionCount + 1, 0);
+    for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+    {
+        long long int partitionRowCount = 0;
+        for (int runCounter = 0; runCounter < runs.size(); runCounter++)
+        {
+            long long int firstRowOffset = boundaries[partitionCounter][runCounter];
+            long long int lastRowOffset = boundaries[partitionCounter + 1][runCounter];
+            if (firstRowOffset == lastRowOffset)
+                continue;
+            partitionRuns[partitionCounter].push_back(this->sliceSortRun(runs[runCounter], firstRowOffset, lastRowOffset));
+            partitionRowCount += lastRowOffset - firstRowOffset;
+        }
+        uint partitionPageCount = (partitionRowCount + this->maxRowsPerBlock - 1) / this->maxRowsPerBlock;
+        firstPageIndices[partitionCounter + 1] = firstPageIndices[partitionCounter] + partitionPageCount;
+    }
+
+    this->reservePages(firstPageIndices[partitionCount]);
+    parallelFor(partitionCount, [&](uint partitionCounter) {
+        if (!partitionRuns[partitionCounter].empty())
+            this->mergeSortedRuns(partitionRuns[partitionCounter], firstPageIndices[partitionCounter], comparator);
+    });
+}
+
+/**
+ * @brief Checks if the rows of the table are known to be in the given order,
+ * that is if the order is a prefix of the recorded sortOrder.
+ *
+ * @param columnIndices 
+ * @param sortStrategyList 
+ * @return true 
+ * @return false 
+ */
+bool Table::isSortedOn(const vector<int> &columnIndices, const vector<SortingStrategy> &sortStrategyList)
+{
+    if (columnIndices.size() > this->sortOrder.size())
+        return false;
+    for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+        if (this->sortOrder[columnCounter] != make_pair(columnIndices[columnCounter], sortStrategyList[columnCounter]))
+            return false;
+    return true;
+}
+
+/**
+ * @brief Creates a copy of the table named copyTableName and adds it to the
+ * tableCatalogue. Operators that sort their input (ORDER, GROUP and JOIN) sort
+ * such a copy. The copy shares the page files of the table (see
+ * BufferManager::sharePage), so it costs no page reads or writes, and a page
+ * is only copied once the copy or the table overwrites it.
+ *
+ * Unless the order is already known, the rows are checked against the order
+ * they are about to be sorted in, up to the first row out of order, so that
+ * the copy can record the order and skip the sort if the input already happens
+ * to be in it.
+ *
+ * @param copyTableName 
+ * @param columnIndices 
+ * @param sortStrategyList 
+ * @return Table* 
+ */
+Table* Table::createCopy(string copyTableName, vector<int> columnIndices, vector<SortingStrategy> sortStrategyList)
+{
+    logger.log("Table::createCopy");
+    Table *copyTable = new Table(copyTableName);
+    copyTable->columns = this->columns;
+    copyTable->distinctValuesPerColumnCount = this->distinctValuesPerColumnCount;
+    copyTable->columnCount = this->columnCount;
+    copyTable->rowCount = this->rowCount;
+    copyTable->blockCount = this->blockCount;
+    copyTable->maxRowsPerBlock = this->maxRowsPerBlock;
+    copyTable->rowsPerBlockCount = this->rowsPerBlockCount;
+    copyTable->sortOrder = this->sortOrder;
+
+    for (uint pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
+    {
+        if (bufferManager.sharePage(this->tableName, pageCounter, copyTableName, pageCounter))
+            continue;
+        Page page = bufferManager.getPage(this->tableName, pageCounter, false);
+        bufferManager.writePage(copyTableName, pageCounter, page.getRows(), this->rowsPerBlockCount[pageCounter]);
+    }
+
+    RowComparator comparator = {columnIndices, sortStrategyList};
+    bool checkOrder = !this->isSortedOn(columnIndices, sortStrategyList);
+    bool inOrder = true;
+    vector<int> lastRow;
+    for (uint pageCounter = 0; checkOrder && inOrder && pageCounter < this->blockCount; pageCounter++)
+    {
+        uint pageRowCount = this->rowsPerBlockCount[pageCounter];
+        if (pageRowCount == 0)
+            continue;
+        Page page = bufferManager.getPage(this->tableName, pageCounter, false);
+        if (!lastRow.empty() && comparator(page.getRowReference(0), lastRow))
+            inOrder = false;
+        for (uint rowCounter = 1; inOrder && rowCounter < pageRowCount; rowCounter++)
+            if (comparator(page.getRowReference(rowCounter), page.getRowReference(rowCounter - 1)))
+                inOrder = false;
+        lastRow = page.getRowReference(pageRowCount - 1);
+    }
+
+    if (checkOrder && inOrder)
+    {
+        copyTable->sortOrder.clear();
+        for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+            copyTable->sortOrder.emplace_back(columnIndices[columnCounter], sortStrategyList[columnCounter]);
+        if (this->sortOrder.empty())
+            this->sortOrder = copyTable->sortOrder;
+    }
+    tableCatalogue.insertTable(copyTable);
+    return copyTable;
+}
+
+/**
+ * @brief Sorts a table that fits in the buffer pool: every page is read once,
+ * the rows are sorted in memory (radix sorted on normalized keys when the key
+ * allows it) and written back once, in place.
+ *
+ * @param comparator 
+ */
+void Table::sortInMemory(const RowComparator &comparator)
+{
+    logger.log("Table::sortInMemory");
+    vector<vector<int>> memoryRows;
+    memoryRows.reserve(this->rowCount);
+    for (uint pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(this->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < this->rowsPerBlockCount[pageCounter]; rowCounter++)
+            memoryRows.push_back(page.getRowReference(rowCounter));
+    }
+
+    vector<pair<unsigned long long, uint>> keys;
+    if (comparator.hasNormalizedKey())
+    {
+        keys.reserve(memoryRows.size());
+        for (uint rowCounter = 0; rowCounter < memoryRows.size(); rowCounter++)
+            keys.push_back({comparator.normalizedKey(memoryRows[rowCounter]), rowCounter});
+        radixSortKeys(keys);
+    }
+    else
+        sort(memoryRows.begin(), memoryRows.end(), comparator);
+
+    uint oldBlockCount = this->blockCount;
+    this->blockCount = 0;
+    this->rowsPerBlockCount.clear();
+    vector<vector<int>> rows(this->maxRowsPerBlock);
+    for (uint rowOffset = 0; rowOffset < memoryRows.size(); rowOffset += this->maxRowsPerBlock)
+    {
+        uint rowCount = min((size_t)this->maxRowsPerBlock, memoryRows.size() - rowOffset);
+        for (uint rowCounter = 0; rowCounter < rowCount; rowCounter++)
+            rows[rowCounter].swap(memoryRows[keys.empty() ? rowOffset + rowCounter : keys[rowOffset + rowCounter].second]);
+        this->writePage(this->blockCount, rows, rowCount);
+    }
+    for (uint pageCounter = this->blockCount; pageCounter < oldBlockCount; pageCounter++)
+        bufferManager.deleteFile(this->tableName, pageCounter);
+}
+
+/**
+ * @brief External sort on the given columns. Nothing is done if the table is
+ * already known to be in that order (see isSortedOn), otherwise the order is
+ * recorded in sortOrder. A table that fits in the buffer pool is sorted in
+ * memory (see sortInMemory). Sorting moves rows, so an index on the table is
+ * rebuilt afterwards.
+ *
+ * Larger tables are split into up to THREAD_COUNT contiguous page ranges and
+ * each worker thread generates runs from its range (see generateSortedRuns),
+ * into a run table of its own. A worker is only started for every run
+ * generation buffer's worth of pages, so small tables are sorted by a single
+ * thread. The workers split the buffer pool between them, each with an
+ * input and an output frame and at least four row frames of its own, so a
+ * small buffer pool generates runs in a single thread.
+ *
+ * The runs are merged BLOCK_COUNT - 3 at a time, but at least two at a time
+ * (one frame is kept for prefetching and two for the double buffered output
+ * page). Intermediate merge passes alternate between two run tables, with the
+ * groups of a pass merged in parallel, and the final pass writes straight into
+ * the pages of this table, split by key range across threads. Only as many
+ * merges run at once as the buffer pool has frames for.
+ *
+ * @param columnIndices 
+ * @param sortStrategyList 
+ */
 void Table::sortTable(vector<int> columnIndices, vector<SortingStrategy> sortStrategyList)
 {
-    logger.log("Table::sortTable");
+    logger.log("Table::sortTable");
+    if (this->isSortedOn(columnIndices, sortStrategyList))
+        return;
+    this->sortOrder.clear();
+    for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+        this->sortOrder.emplace_back(columnIndices[columnCounter], sortStrategyList[columnCounter]);
+    if (this->blockCount == 0)
+        return;
+
+    RowComparator comparator = {columnIndices, sortStrategyList};
+    if (this->blockCount <= BLOCK_COUNT)
+    {
+        this->sortInMemory(comparator);
+        if (this->indexed)
+            this->buildIndex(this->indexedColumn, this->indexingStrategy);
+        return;
+    }
+
+    // Run Generation Phase
+    // Runs from too small a budget would make for more merge passes than the
+    // extra threads save
+    const uint MIN_WORKER_PAGE_COUNT = 4;
+    uint memoryPageCount = memoryFrames(2);
+    uint workerCount = max(1u, min({THREAD_COUNT, this->blockCount / memoryPageCount, BLOCK_COUNT / (MIN_WORKER_PAGE_COUNT + 2)}));
+    uint workerPageCount = workerCount == 1 ? memoryPageCount : BLOCK_COUNT / workerCount - 2;
+    vector<Table*> runTables;
+    for (uint workerCounter = 0; workerCounter < workerCount; workerCounter++)
+        runTables.push_back(this->createRunTable("$sortRun" + to_string(workerCounter) + "_" + this->tableName));
+
+    vector<vector<SortRun>> workerRuns(workerCount);
+    parallelFor(workerCount, [&](uint workerCounter) {
+        uint firstPageIndex = (uint)((unsigned long long)this->blockCount * workerCounter / workerCount);
+        uint lastPageIndex = (uint)((unsigned long long)this->blockCount * (workerCounter + 1) / workerCount);
+        workerRuns[workerCounter] = this->generateSortedRuns(runTables[workerCounter], firstPageIndex, lastPageIndex, workerPageCount, comparator);
+    });
+
+    vector<SortRun> runs;
+    for (auto &generatedRuns : workerRuns)
+        runs.insert(runs.end(), generatedRuns.begin(), generatedRuns.end());
+
+    // Merge Phase
+    Table *mergeRunTable = this->createRunTable("$sortRunMerge_" + this->tableName);
+    Table *destinationRunTable = mergeRunTable;
+    uint degreeOfMerge = BLOCK_COUNT > 4 ? BLOCK_COUNT - 3 : 2;
+    while (runs.size() > degreeOfMerge)
+    {
+        vector<vector<SortRun>> runGroups;
+        vector<uint> firstPageIndices;
+        uint pageIndex = 0;
+        for (int runCounter = 0; runCounter < runs.size(); runCounter += degreeOfMerge)
+        {
+            runGroups.emplace_back(runs.begin() + runCounter, runs.begin() + min((size_t)runCounter + degreeOfMerge, runs.size()));
+            long long int groupRowCount = 0;
+            for (auto &run : runGroups.back())
+                groupRowCount += run.rowCount;
+            firstPageIndices.push_back(pageIndex);
+            pageIndex += (groupRowCount + this->maxRowsPerBlock - 1) / this->maxRowsPerBlock;
+        }
+
+        destinationRunTable->reservePages(pageIndex);
+        vector<SortRun> mergedRuns(runGroups.size());
+        parallelFor(runGroups.size(), [&](uint groupCounter) {
+            mergedRuns[groupCounter] = destinationRunTable->mergeSortedRuns(runGroups[groupCounter], firstPageIndices[groupCounter], comparator);
+        }, max(1u, BLOCK_COUNT / (degreeOfMerge + 3)));
+        runs = mergedRuns;
+        destinationRunTable = (destinationRunTable == mergeRunTable) ? runTables[0] : mergeRunTable;
+    }
+
+    uint oldBlockCount = this->blockCount;
+    this->blockCount = 0;
+    this->rowsPerBlockCount.clear();
+    if (runs.size() == 1)
+    {
+        // A single run is already laid out as a packed table, move its pages
+        Table *runTable = runs[0].table;
+        for (uint pageCounter = 0; pageCounter < runs[0].pageCount; pageCounter++)
+            bufferManager.renameFile(runTable->tableName, this->tableName, pageCounter);
+        this->rowsPerBlockCount.assign(runTable->rowsPerBlockCount.begin(), runTable->rowsPerBlockCount.begin() + runs[0].pageCount);
+        this->blockCount = runs[0].pageCount;
+        for (uint pageCounter = runs[0].pageCount; pageCounter < runTable->blockCount; pageCounter++)
+            bufferManager.deleteFile(runTable->tableName, pageCounter);
+        runTable->blockCount = 0;
+    }
+    else
+    {
+        uint runPageCount = 0;
+        for (auto &run : runs)
+            runPageCount += run.pageCount;
+        // Every partition merges from all runs at once
+        uint partitionCount = min({THREAD_COUNT, runPageCount / memoryPageCount, BLOCK_COUNT / ((uint)runs.size() + 3)});
+        if (partitionCount > 1)
+            this->partitionedMergeSortedRuns(runs, partitionCount, comparator);
+        else
+            this->mergeSortedRuns(runs, 0, comparator);
+    }
+
+    for (uint pageCounter = this->blockCount; pageCounter < oldBlockCount; pageCounter++)
+        bufferManager.deleteFile(this->tableName, pageCounter);
+
+    for (Table *runTable : runTables)
+        tableCatalogue.deleteTable(runTable->tableName);
+    tableCatalogue.deleteTable(mergeRunTable->tableName);
+
+    if (this->indexed)
+        this->buildIndex(this->indexedColumn, this->indexingStrategy);
+}
+
+/**
+ * @brief Fills this table with the first limit rows of table in the given
+ * order (ORDER BY ... LIMIT) after a single scan of table. The caller makes
+ * sure that limit rows fit in memory unless table is already in that order,
+ * in which case its first limit rows are copied as they are. Small limits are
+ * kept in a bounded heap whose top is the worst row kept so far. Larger ones
+ * go through a buffer of 2 * limit rows: whenever it fills up, it is cut down
+ * to its best limit rows and the worst of those becomes a cutoff that later
+ * rows have to beat to be buffered at all.
+ *
+ * @param table 
+ * @param columnIndices 
+ * @param sortStrategyList 
+ * @param limit 
+ */
+void Table::topKTable(Table *table, vector<int> columnIndices, vector<SortingStrategy> sortStrategyList, long long int limit)
+{
+    logger.log("Table::topKTable");
+    RowComparator comparator = {columnIndices, sortStrategyList};
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    this->sortOrder.clear();
+    for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+        this->sortOrder.emplace_back(columnIndices[columnCounter], sortStrategyList[columnCounter]);
+
+    vector<vector<int>> rows;
+    auto writeRow = [&](const vector<int> &row) {
+        rows.push_back(row);
+        this->updateStatistics(row);
+        if (rows.size() == this->maxRowsPerBlock)
+        {
+            this->writePage(this->blockCount, rows, rows.size());
+            rows.clear();
+        }
+    };
+
+    if (table->isSortedOn(columnIndices, sortStrategyList))
+    {
+        for (uint pageCounter = 0; pageCounter < table->blockCount && this->rowCount < limit; pageCounter++)
+        {
+            Page page = bufferManager.getPage(table->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < table->rowsPerBlockCount[pageCounter] && this->rowCount < limit; rowCounter++)
+                writeRow(page.getRowReference(rowCounter));
+        }
+    }
+    else
+    {
+        uint memoryRowCount = memoryFrames(2) * this->maxRowsPerBlock;
+        bool useHeap = limit <= this->maxRowsPerBlock || 2 * limit > memoryRowCount;
+        priority_queue<vector<int>, vector<vector<int>>, RowComparator> heap(comparator);
+        vector<vector<int>> buffer;
+        vector<int> cutoff;
+
+        for (uint pageCounter = 0; pageCounter < table->blockCount; pageCounter++)
+        {
+            Page page = bufferManager.getPage(table->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < table->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                const vector<int> &row = page.getRowReference(rowCounter);
+                if (useHeap)
+                {
+                    if (heap.size() < limit)
+                        heap.push(row);
+                    else if (comparator(row, heap.top()))
+                    {
+                        heap.pop();
+                        heap.push(row);
+                    }
+                }
+                else if (cutoff.empty() || comparator(row, cutoff))
+                {
+                    buffer.push_back(row);
+                    if (buffer.size() == 2 * limit)
+                    {
+                        nth_element(buffer.begin(), buffer.begin() + limit - 1, buffer.end(), comparator);
+                        cutoff = buffer[limit - 1];
+                        buffer.resize(limit);
+                    }
+                }
+            }
+        }
+
+        if (useHeap)
+        {
+            while (!heap.empty())
+            {
+                buffer.push_back(heap.top());
+                heap.pop();
+            }
+            reverse(buffer.begin(), buffer.end());
+        }
+        else
+        {
+            sort(buffer.begin(), buffer.end(), comparator);
+            if (buffer.size() > limit)
+                buffer.resize(limit);
+        }
+        for (auto &row : buffer)
+            writeRow(row);
+    }
+
+    if (!rows.empty())
+        this->writePage(this->blockCount, rows, rows.size());
+}
+
+/**
+ * @brief Drops every row after the first rowLimit rows of the table. Only the
+ * page holding the last row kept is rewritten, and the column statistics are
+ * then recomputed from a scan of the rows kept.
+ *
+ * @param rowLimit 
+ */
+void Table::truncate(long long int rowLimit)
+{
+    logger.log("Table::truncate");
+    if (rowLimit >= this->rowCount)
+        return;
+
+    uint keptBlockCount = 0;
+    long long int rowsLeft = rowLimit;
+    while (rowsLeft > 0)
+    {
+        uint pageRowCount = this->rowsPerBlockCount[keptBlockCount];
+        if (rowsLeft < pageRowCount)
+        {
+            Page page = bufferManager.getPage(this->tableName, keptBlockCount, false);
+            this->writePage(keptBlockCount, page.getRows(), rowsLeft);
+            pageRowCount = rowsLeft;
+        }
+        rowsLeft -= pageRowCount;
+        keptBlockCount++;
+    }
+
+    for (uint pageCounter = keptBlockCount; pageCounter < this->blockCount; pageCounter++)
+        bufferManager.deleteFile(this->tableName, pageCounter);
+    this->blockCount = keptBlockCount;
+    this->rowsPerBlockCount.resize(keptBlockCount);
+
+    this->rowCount = 0;
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    for (uint pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(this->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < this->rowsPerBlockCount[pageCounter]; rowCounter++)
+            this->updateStatistics(page.getRowReference(rowCounter));
+    }
+}
+
+/**
+ * @brief Folds a batch of values of a column into an aggregate state. There is
+ * one specialization per aggregate function, chosen once per query (see
+ * GroupAggregate), so the loops have no branches on the function and the
+ * compiler can vectorize them. COUNT only counts the values, its batch may be
+ * empty of data.
+ *
+ * @tparam aggregateFunction 
+ * @param state 
+ * @param values 
+ * @param valueCount 
+ */
+template <AggregateFunction aggregateFunction>
+void aggregateValues(long long int &state, const int *values, size_t valueCount)
+{
+    long long int result = state;
+    if constexpr (aggregateFunction == AGGREGATE_MAX)
+    {
+        for (size_t valueCounter = 0; valueCounter < valueCount; valueCounter++)
+            result = max(result, (long long int)values[valueCounter]);
+    }
+    else if constexpr (aggregateFunction == AGGREGATE_MIN)
+    {
+        for (size_t valueCounter = 0; valueCounter < valueCount; valueCounter++)
+            result = min(result, (long long int)values[valueCounter]);
+    }
+    else if constexpr (aggregateFunction == AGGREGATE_COUNT)
+        result += valueCount;
+    else
+    {
+        for (size_t valueCounter = 0; valueCounter < valueCount; valueCounter++)
+            result += values[valueCounter];
+    }
+    state = result;
+}
+
+GroupAggregate::GroupAggregate(AggregateFunction aggregateFunction, int columnIndex)
+{
+    this->aggregateFunction = aggregateFunction;
+    this->columnIndex = columnIndex;
+    switch (aggregateFunction)
+    {
+    case AGGREGATE_SUM:
+        this->kernel = aggregateValues<AGGREGATE_SUM>;
+        this->identity = 0;
+        break;
+    case AGGREGATE_MAX:
+        this->kernel = aggregateValues<AGGREGATE_MAX>;
+        this->identity = LLONG_MIN;
+        break;
+    case AGGREGATE_MIN:
+        this->kernel = aggregateValues<AGGREGATE_MIN>;
+        this->identity = LLONG_MAX;
+        break;
+    case AGGREGATE_AVG:
+        this->kernel = aggregateValues<AGGREGATE_AVG>;
+        this->identity = 0;
+        break;
+    default:
+        this->kernel = aggregateValues<AGGREGATE_COUNT>;
+        this->identity = 0;
+        break;
+    }
+}
+
+/**
+ * @brief Every aggregate state of GROUP BY has the same layout, a run of
+ * aggregates.size() + 1 64 bit slots: the running value of each aggregate in
+ * order, starting from its identity, followed by the number of rows of the
+ * group. AVG keeps a sum, so the states of a group aggregated apart, for
+ * instance by different threads, can be combined (see mergeGroupState).
+ *
+ * @param aggregates 
+ * @param state 
+ */
+void initializeGroupState(const vector<GroupAggregate> &aggregates, long long int *state)
+{
+    for (int aggregateCounter = 0; aggregateCounter < aggregates.size(); aggregateCounter++)
+        state[aggregateCounter] = aggregates[aggregateCounter].identity;
+    state[aggregates.size()] = 0;
+}
+
+/**
+ * @brief Folds a single row into a group state. The hash paths meet the groups
+ * of a page in random order, so there is no batch to hand to the kernels, and
+ * the function is switched on inline rather than called through the kernel
+ * pointer for every row and aggregate.
+ *
+ * @param aggregates 
+ * @param state 
+ * @param row 
+ */
+void accumulateGroupState(const vector<GroupAggregate> &aggregates, long long int *state, const vector<int> &row)
+{
+    for (int aggregateCounter = 0; aggregateCounter < aggregates.size(); aggregateCounter++)
+    {
+        const GroupAggregate &aggregate = aggregates[aggregateCounter];
+        switch (aggregate.aggregateFunction)
+        {
+        case AGGREGATE_MAX:
+            state[aggregateCounter] = max(state[aggregateCounter], (long long int)row[aggregate.columnIndex]);
+            break;
+        case AGGREGATE_MIN:
+            state[aggregateCounter] = min(state[aggregateCounter], (long long int)row[aggregate.columnIndex]);
+            break;
+        case AGGREGATE_COUNT:
+            state[aggregateCounter]++;
+            break;
+        default:
+            state[aggregateCounter] += row[aggregate.columnIndex];
+            break;
+        }
+    }
+    state[aggregates.size()]++;
+}
+
+void mergeGroupState(const vector<GroupAggregate> &aggregates, long long int *state, const long long int *otherState)
+{
+    for (int aggregateCounter = 0; aggregateCounter < aggregates.size(); aggregateCounter++)
+    {
+        if (aggregates[aggregateCounter].aggregateFunction == AGGREGATE_MAX)
+            state[aggregateCounter] = max(state[aggregateCounter], otherState[aggregateCounter]);
+        else if (aggregates[aggregateCounter].aggregateFunction == AGGREGATE_MIN)
+            state[aggregateCounter] = min(state[aggregateCounter], otherState[aggregateCounter]);
+        else
+            state[aggregateCounter] += otherState[aggregateCounter];
+    }
+    state[aggregates.size()] += otherState[aggregates.size()];
+}
+
+/**
+ * @brief Partial states are written to relations as ints, each 64 bit slot as
+ * its high half followed by its low half.
+ *
+ * @param row 
+ * @param state 
+ * @param stateSize 
+ */
+void appendGroupState(vector<int> &row, const long long int *state, size_t stateSize)
+{
+    for (size_t slotCounter = 0; slotCounter < stateSize; slotCounter++)
+    {
+        row.push_back((int)((unsigned long long)state[slotCounter] >> 32));
+        row.push_back((int)(uint32_t)state[slotCounter]);
+    }
+}
+
+void readGroupState(const vector<int> &row, size_t firstColumnIndex, long long int *state, size_t stateSize)
+{
+    for (size_t slotCounter = 0; slotCounter < stateSize; slotCounter++)
+        state[slotCounter] = (long long int)(((unsigned long long)(uint32_t)row[firstColumnIndex + 2 * slotCounter] << 32) | (uint32_t)row[firstColumnIndex + 2 * slotCounter + 1]);
+}
+
+/**
+ * @brief Hash of the values of a group, combined from the hashes of each
+ * value (see hashJoinKey).
+ *
+ * @param key 
+ * @param level 
+ * @return unsigned long long 
+ */
+unsigned long long hashGroupKey(const vector<int> &key, int level)
+{
+    unsigned long long hash = 0;
+    for (int value : key)
+        hash = hashJoinKey(value, level) ^ (hash * 0x9E3779B97F4A7C15ULL);
+    return hash;
+}
+
+struct GroupKeyHash
+{
+    size_t operator()(const vector<int> &key) const
+    {
+        return hashGroupKey(key, 0);
+    }
+};
+
+/**
+ * @brief Finishes the aggregates of a group and, unless the HAVING aggregate
+ * (the first one) fails its condition, adds the grouping values followed by
+ * the returned aggregates as a result row. Columns are ints, so an aggregate
+ * outside their range (a large SUM) is stored saturated and a warning is
+ * logged.
+ *
+ * @param groupKey 
+ * @param aggregates 
+ * @param state 
+ * @param havingBinaryOperator NO_BINOP_CLAUSE if there is no HAVING clause
+ * @param havingValue 
+ * @param rows output page buffer
+ */
+void Table::writeGroupRow(const vector<int> &groupKey, const vector<GroupAggregate> &aggregates, const long long int *state, BinaryOperator havingBinaryOperator, int havingValue, vector<vector<int>> &rows)
+{
+    vector<int> resultRow = groupKey;
+    long long int groupRowCount = state[aggregates.size()];
+    for (int aggregateCounter = 0; aggregateCounter < aggregates.size(); aggregateCounter++)
+    {
+        long long int value = state[aggregateCounter];
+        if (aggregates[aggregateCounter].aggregateFunction == AGGREGATE_AVG)
+            value /= groupRowCount;
+
+        if (aggregateCounter == 0 && havingBinaryOperator != NO_BINOP_CLAUSE)
+        {
+            if (!evaluateBinOp(value, havingValue, havingBinaryOperator))
+                return;
+            continue;
+        }
+        if (value > INT_MAX || value < INT_MIN)
+        {
+            LOG_WARN("Table::writeGroupRow: " + this->tableName + "." + this->columns[resultRow.size()] + " of a group is " + to_string(value) + ", out of int range");
+            value = value > INT_MAX ? INT_MAX : INT_MIN;
+        }
+        resultRow.push_back(value);
+    }
+
+    rows.push_back(resultRow);
+    this->updateStatistics(resultRow);
+    if (rows.size() == this->maxRowsPerBlock)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
+
+/**
+ * @brief GROUP BY over a table sorted on the grouping columns. Each group is a
+ * run of consecutive rows, all of its aggregates are computed while it is
+ * read. The aggregated columns of a page are first copied out into column
+ * batches, and the kernel of each aggregate is then run once per run of rows
+ * of the same group within the page.
+ *
+ * @param table 
+ * @param groupColumnIndices 
+ * @param aggregates the HAVING aggregate, if any, followed by the returned
+ * aggregates
+ * @param havingBinaryOperator NO_BINOP_CLAUSE if there is no HAVING clause
+ * @param havingValue 
+ */
+void Table::groupTable(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue)
+{
+    logger.log("Table::groupTable");
+
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    if (table->rowCount == 0)
+        return;
+
+    vector<vector<int>> rows;
+    vector<int> groupKey;
+    vector<long long int> state(aggregates.size() + 1);
+    vector<vector<int>> columnBatches(aggregates.size());
+
+    for (uint pageCounter = 0; pageCounter < table->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(table->tableName, pageCounter, false);
+        uint pageRowCount = table->rowsPerBlockCount[pageCounter];
+        for (int aggregateCounter = 0; aggregateCounter < aggregates.size(); aggregateCounter++)
+        {
+            if (aggregates[aggregateCounter].columnIndex == -1)
+                continue;
+            columnBatches[aggregateCounter].resize(pageRowCount);
+            for (uint rowCounter = 0; rowCounter < pageRowCount; rowCounter++)
+                columnBatches[aggregateCounter][rowCounter] = page.getRowReference(rowCounter)[aggregates[aggregateCounter].columnIndex];
+        }
+
+        uint firstRowIndex = 0;
+        while (firstRowIndex < pageRowCount)
+        {
+            const vector<int> &firstRow = page.getRowReference(firstRowIndex);
+            bool sameGroup = !groupKey.empty();
+            for (int columnCounter = 0; sameGroup && columnCounter < groupColumnIndices.size(); columnCounter++)
+                sameGroup = (firstRow[groupColumnIndices[columnCounter]] == groupKey[columnCounter]);
+            if (!sameGroup)
+            {
+                if (!groupKey.empty())
+                    this->writeGroupRow(groupKey, aggregates, state.data(), havingBinaryOperator, havingValue, rows);
+                groupKey.clear();
+                for (int groupColumnIndex : groupColumnIndices)
+                    groupKey.push_back(firstRow[groupColumnIndex]);
+                initializeGroupState(aggregates, state.data());
+            }
+
+            uint lastRowIndex = firstRowIndex + 1;
+            while (lastRowIndex < pageRowCount)
+            {
+                const vector<int> &row = page.getRowReference(lastRowIndex);
+                bool inGroup = true;
+                for (int columnCounter = 0; inGroup && columnCounter < groupColumnIndices.size(); columnCounter++)
+                    inGroup = (row[groupColumnIndices[columnCounter]] == groupKey[columnCounter]);
+                if (!inGroup)
+                    break;
+                lastRowIndex++;
+            }
+
+            for (int aggregateCounter = 0; aggregateCounter < aggregates.size(); aggregateCounter++)
+            {
+                const GroupAggregate &aggregate = aggregates[aggregateCounter];
+                aggregate.kernel(state[aggregateCounter], aggregate.columnIndex == -1 ? nullptr : columnBatches[aggregateCounter].data() + firstRowIndex, lastRowIndex - firstRowIndex);
+            }
+            state[aggregates.size()] += lastRowIndex - firstRowIndex;
+            firstRowIndex = lastRowIndex;
+        }
+    }
+    this->writeGroupRow(groupKey, aggregates, state.data(), havingBinaryOperator, havingValue, rows);
+
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
+
+/**
+ * @brief GROUP BY with hash aggregation, one pass over table whatever its
+ * order (see hashGroupPartition). Result rows come out in no particular order.
+ * With more than one thread (THREAD_COUNT), a table larger than the memory of
+ * one thread is aggregated in parallel (see parallelHashGroupTable).
+ *
+ * @param table 
+ * @param groupColumnIndices 
+ * @param aggregates the HAVING aggregate, if any, followed by the returned
+ * aggregates
+ * @param havingBinaryOperator NO_BINOP_CLAUSE if there is no HAVING clause
+ * @param havingValue 
+ */
+void Table::hashGroupTable(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue)
+{
+    logger.log("Table::hashGroupTable");
+
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+
+    if (THREAD_COUNT > 1 && table->blockCount > memoryFrames(2))
+    {
+        this->parallelHashGroupTable(table, groupColumnIndices, aggregates, havingBinaryOperator, havingValue);
+        return;
+    }
+
+    vector<vector<int>> rows;
+    this->hashGroupPartition(table, groupColumnIndices, aggregates, havingBinaryOperator, havingValue, 0, memoryFrames(2), rows);
+
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
+
+/**
+ * @brief Aggregates the rows of table into an in-memory table of groups keyed
+ * on the grouping columns. The states of the groups are laid out one after the
+ * other in a single array (see initializeGroupState). Of the memoryPageCount
+ * frames the caller has besides the input and output frames, half are set
+ * aside for the page buffers of the partitions rows spill to, and the groups
+ * get the rest, a result page's worth of groups per frame.
+ *
+ * Once the table of groups is full, rows of the groups already in it are still
+ * aggregated in memory, while rows of new groups are spilled to partitions by
+ * the hash of their key. After the scan the groups in memory are written out
+ * and every partition is aggregated the same way with a new hash seed. A group
+ * is never both in memory and spilled, so none is written twice. Past a few
+ * levels partitions are aggregated without a limit on the groups.
+ *
+ * Heavy hitters, estimated from a sample (see findHeavyGroupKeys), are put in
+ * the table of groups before the scan, so that a large group is never spilled
+ * just because its first row came late.
+ *
+ * @param table 
+ * @param groupColumnIndices 
+ * @param aggregates 
+ * @param havingBinaryOperator 
+ * @param havingValue 
+ * @param level recursion depth, used to seed the hash function
+ * @param memoryPageCount 
+ * @param rows output page buffer
+ * @param mergePartialStates if set, the rows of table are partial aggregate
+ * states, the state of each row following its grouping columns (see
+ * appendGroupState), and they are merged rather than aggregated
+ */
+void Table::hashGroupPartition(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue, int level, uint memoryPageCount, vector<vector<int>> &rows, bool mergePartialStates)
+{
+    logger.log("Table::hashGroupPartition");
+    const int MAX_PARTITIONING_LEVEL = 3;
+    uint partitionCount = max(1u, memoryPageCount / 2);
+    size_t groupCapacity = (size_t)max(1u, memoryPageCount - partitionCount) * this->maxRowsPerBlock;
+    size_t stateSize = aggregates.size() + 1;
+
+    unordered_map<vector<int>, size_t, GroupKeyHash> groupOffsets;
+    vector<long long int> groupStates, partialState(stateSize);
+    vector<int> groupKey(groupColumnIndices.size());
+    vector<Table*> partitions;
+    vector<vector<vector<int>>> buffers;
+
+    // Every row of a group first seen once the table of groups is full is
+    // spilled, and re-read at each level. Keys that would fill a partition
+    // page by themselves are found from a sample and made resident up front,
+    // taking at most half of the group slots
+    if (!mergePartialStates && level < MAX_PARTITIONING_LEVEL && table->blockCount > memoryPageCount)
+    {
+        for (auto &heavyKey : table->findHeavyGroupKeys(groupColumnIndices, table->maxRowsPerBlock))
+        {
+            if (groupOffsets.size() >= groupCapacity / 2)
+                break;
+            groupOffsets.emplace(heavyKey, groupStates.size());
+            groupStates.resize(groupStates.size() + stateSize);
+            initializeGroupState(aggregates, &groupStates[groupStates.size() - stateSize]);
+        }
+        if (!groupOffsets.empty())
+            LOG_DEBUG("Table::hashGroupPartition: " + to_string(groupOffsets.size()) + " heavy keys in " + table->tableName);
+    }
 
-    // Comparator for Sort Function
-    auto cmpSort = [this, columnIndices, sortStrategyList](vector<int> &a, vector<int> &b) {
-        for(int i = 0; i < columnIndices.size(); i++) {
-            if(sortStrategyList[i] == ASC) {
-                if(a[columnIndices[i]] < b[columnIndices[i]]) return true;
-                if(a[columnIndices[i]] > b[columnIndices[i]]) return false;
+    for (uint pageCounter = 0; pageCounter < table->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(table->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < table->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            const vector<int> &row = page.getRowReference(rowCounter);
+            for (int columnCounter = 0; columnCounter < groupColumnIndices.size(); columnCounter++)
+                groupKey[columnCounter] = row[groupColumnIndices[columnCounter]];
+            auto group = groupOffsets.find(groupKey);
+            if (group == groupOffsets.end())
+            {
+                if (groupOffsets.size() >= groupCapacity && level < MAX_PARTITIONING_LEVEL)
+                {
+                    if (partitions.empty())
+                    {
+                        for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+                            partitions.push_back(table->createRunTable("$hashGroup" + to_string(partitionCounter) + "_" + to_string(level) + "_" + table->tableName));
+                        buffers.assign(partitionCount, {});
+                    }
+                    uint partitionCounter = hashGroupKey(groupKey, level + 1) % partitionCount;
+                    buffers[partitionCounter].push_back(row);
+                    partitions[partitionCounter]->rowCount++;
+                    if (buffers[partitionCounter].size() == table->maxRowsPerBlock)
+                    {
+                        partitions[partitionCounter]->writePage(partitions[partitionCounter]->blockCount, buffers[partitionCounter], buffers[partitionCounter].size());
+                        buffers[partitionCounter].clear();
+                    }
+                    continue;
+                }
+                group = groupOffsets.emplace(groupKey, groupStates.size()).first;
+                groupStates.resize(groupStates.size() + stateSize);
+                initializeGroupState(aggregates, &groupStates[group->second]);
             }
-            else {
-                if(a[columnIndices[i]] < b[columnIndices[i]]) return false;
-                if(a[columnIndices[i]] > b[columnIndices[i]]) return true;
+            if (mergePartialStates)
+            {
+                readGroupState(row, groupColumnIndices.size(), partialState.data(), stateSize);
+                mergeGroupState(aggregates, &groupStates[group->second], partialState.data());
             }
+            else
+                accumulateGroupState(aggregates, &groupStates[group->second], row);
         }
-        return false;
-    };
-    
-    // Sorting Phase
-    Cursor cursor(tableName, 0);
-    for(int i = 0; i < blockCount; i++) {
-        vector<vector<int>> rows = cursor.getPage();
-        int nRows = rowsPerBlockCount[i];
-        sort(rows.begin(), rows.begin() + nRows, cmpSort);
-        bufferManager.writePage(tableName, i, rows, nRows);
-        bufferManager.deleteFromPool(cursor.page.pageName);
-        if(i + 1 < blockCount)  cursor.nextPage(i + 1);
     }
 
+    for (auto &group : groupOffsets)
+        this->writeGroupRow(group.first, aggregates, &groupStates[group.second], havingBinaryOperator, havingValue, rows);
+    groupOffsets.clear();
+    groupStates.clear();
+
+    for (uint partitionCounter = 0; partitionCounter < partitions.size(); partitionCounter++)
+    {
+        Table *partition = partitions[partitionCounter];
+        if (!buffers[partitionCounter].empty())
+            partition->writePage(partition->blockCount, buffers[partitionCounter], buffers[partitionCounter].size());
+        buffers[partitionCounter].clear();
+        if (partition->rowCount > 0)
+            this->hashGroupPartition(partition, groupColumnIndices, aggregates, havingBinaryOperator, havingValue, level + 1, memoryPageCount, rows, mergePartialStates);
+        tableCatalogue.deleteTable(partition->tableName);
+    }
+}
+
+/**
+ * @brief Hash aggregation on up to THREAD_COUNT worker threads, which split
+ * the buffer pool evenly between them. Each worker aggregates its own range of
+ * pages into a thread-local table of groups. When the table fills up, and once
+ * the range is done, the worker writes out the partial state of every group
+ * in it, as a row of the grouping values followed by the state, to a partition
+ * chosen by the hash of the grouping values, and starts afresh. The groups are
+ * written out in partition order through a single page buffer, which is
+ * appended to the shared partition whenever it fills up or the partition
+ * changes, taking the partition's lock only to claim the page index. No rows
+ * are spilled here, only a state per group and flush, so a heavy hitter costs
+ * no more than any other group.
+ *
+ * The partitions hold disjoint groups, so each is then merged as an
+ * independent task within one worker's frames (see hashGroupPartition), into
+ * an output relation of its own whose pages are moved into this table at the
+ * end.
+ *
+ * @param table 
+ * @param groupColumnIndices 
+ * @param aggregates 
+ * @param havingBinaryOperator 
+ * @param havingValue 
+ */
+void Table::parallelHashGroupTable(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue)
+{
+    logger.log("Table::parallelHashGroupTable");
+    uint workerCount = max(1u, min(THREAD_COUNT, BLOCK_COUNT / 3));
+    uint workerPageCount = workerCount == 1 ? memoryFrames(2) : BLOCK_COUNT / workerCount - 2;
+    size_t groupCapacity = (size_t)workerPageCount * this->maxRowsPerBlock;
+    size_t stateSize = aggregates.size() + 1;
+    uint partitionCount = max(workerCount, memoryFrames(2) / 2);
+
+    // Partial State Phase
+    vector<int> stateColumnIndices;
+    vector<Table*> partitions;
+    for (int columnCounter = 0; columnCounter < groupColumnIndices.size(); columnCounter++)
+        stateColumnIndices.push_back(columnCounter);
+    for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+    {
+        Table *partition = new Table("$groupStates" + to_string(partitionCounter) + "_" + this->tableName);
+        for (int columnCounter = 0; columnCounter < groupColumnIndices.size() + 2 * stateSize; columnCounter++)
+            partition->columns.push_back("state" + to_string(columnCounter));
+        partition->columnCount = partition->columns.size();
+        partition->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * partition->columnCount));
+        tableCatalogue.insertTable(partition);
+        partitions.push_back(partition);
+    }
+
+    vector<mutex> partitionMutexes(partitionCount);
+    auto appendPage = [&](uint partitionCounter, vector<vector<int>> &buffer) {
+        Table *partition = partitions[partitionCounter];
+        uint pageIndex;
+        {
+            lock_guard<mutex> lock(partitionMutexes[partitionCounter]);
+            pageIndex = partition->blockCount++;
+            partition->rowsPerBlockCount.push_back(buffer.size());
+            partition->rowCount += buffer.size();
+        }
+        bufferManager.writePage(partition->tableName, pageIndex, buffer, buffer.size());
+        buffer.clear();
+    };
+
+    uint scanWorkerCount = max(1u, min(workerCount, table->blockCount / workerPageCount));
+    parallelFor(scanWorkerCount, [&](uint workerCounter) {
+        unordered_map<vector<int>, size_t, GroupKeyHash> groupOffsets;
+        vector<long long int> groupStates;
+        vector<int> groupKey(groupColumnIndices.size());
+        vector<vector<int>> buffer;
+        auto writePartialStates = [&]() {
+            vector<pair<uint, const pair<const vector<int>, size_t>*>> groups;
+            groups.reserve(groupOffsets.size());
+            for (auto &group : groupOffsets)
+                groups.push_back({hashGroupKey(group.first, 1) % partitionCount, &group});
+            sort(groups.begin(), groups.end(), [](const pair<uint, const pair<const vector<int>, size_t>*> &a, const pair<uint, const pair<const vector<int>, size_t>*> &b) {
+                return a.first < b.first;
+            });
+            for (size_t groupCounter = 0; groupCounter < groups.size(); groupCounter++)
+            {
+                uint partitionCounter = groups[groupCounter].first;
+                buffer.push_back(groups[groupCounter].second->first);
+                appendGroupState(buffer.back(), &groupStates[groups[groupCounter].second->second], stateSize);
+                if (buffer.size() == partitions[partitionCounter]->maxRowsPerBlock || groupCounter + 1 == groups.size() || groups[groupCounter + 1].first != partitionCounter)
+                    appendPage(partitionCounter, buffer);
+            }
+            groupOffsets.clear();
+            groupStates.clear();
+        };
+
+        uint firstPageIndex = (uint)((unsigned long long)table->blockCount * workerCounter / scanWorkerCount);
+        uint lastPageIndex = (uint)((unsigned long long)table->blockCount * (workerCounter + 1) / scanWorkerCount);
+        for (uint pageCounter = firstPageIndex; pageCounter < lastPageIndex; pageCounter++)
+        {
+            Page page = bufferManager.getPage(table->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < table->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                const vector<int> &row = page.getRowReference(rowCounter);
+                for (int columnCounter = 0; columnCounter < groupColumnIndices.size(); columnCounter++)
+                    groupKey[columnCounter] = row[groupColumnIndices[columnCounter]];
+                auto group = groupOffsets.find(groupKey);
+                if (group == groupOffsets.end())
+                {
+                    if (groupOffsets.size() >= groupCapacity)
+                        writePartialStates();
+                    group = groupOffsets.emplace(groupKey, groupStates.size()).first;
+                    groupStates.resize(groupStates.size() + stateSize);
+                    initializeGroupState(aggregates, &groupStates[group->second]);
+                }
+                accumulateGroupState(aggregates, &groupStates[group->second], row);
+            }
+        }
+        writePartialStates();
+    });
 
     // Merge Phase
-    int degreeOfMerge = BLOCK_COUNT - 1;
-    int totalLevels = ceil(log2(blockCount) / log2(degreeOfMerge));
+    vector<Table*> outputTables;
+    for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+    {
+        outputTables.push_back(this->createRunTable("$groupOutput" + to_string(partitionCounter) + "_" + this->tableName));
+        outputTables.back()->distinctValuesInColumns.assign(this->columnCount, {});
+        outputTables.back()->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    }
+    parallelFor(partitionCount, [&](uint partitionCounter) {
+        Table *outputTable = outputTables[partitionCounter];
+        Table *partition = partitions[partitionCounter];
+        vector<vector<int>> rows;
+        if (partition->rowCount > 0)
+            outputTable->hashGroupPartition(partition, stateColumnIndices, aggregates, havingBinaryOperator, havingValue, 1, workerPageCount, rows, true);
+        if (!rows.empty())
+            outputTable->writePage(outputTable->blockCount, rows, rows.size());
+        tableCatalogue.deleteTable(partition->tableName);
+    }, workerCount);
+    this->appendOutputTables(outputTables);
+}
+
+/**
+ * @brief Cross product of table1 and table2 with a block nested loop. Chunks
+ * of all buffer frames but one input and one output frame are read from
+ * table1, and table2 is scanned once per chunk, pairing each of its pages with
+ * every row of the chunk. Result rows go straight to the pages of this table.
+ *
+ * @param table1 
+ * @param table2 
+ */
+void Table::crossTable(Table *table1, Table *table2)
+{
+    logger.log("Table::crossTable");
 
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+
+    vector<vector<int>> rows;
+    uint chunkPageCount = memoryFrames(2);
+    vector<vector<int>> chunkRows;
+    for (uint firstPageIndex = 0; firstPageIndex < table1->blockCount; firstPageIndex += chunkPageCount)
+    {
+        chunkRows.clear();
+        for (uint pageCounter = firstPageIndex; pageCounter < min(table1->blockCount, firstPageIndex + chunkPageCount); pageCounter++)
+        {
+            Page page = bufferManager.getPage(table1->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < table1->rowsPerBlockCount[pageCounter]; rowCounter++)
+                chunkRows.push_back(page.getRowReference(rowCounter));
+        }
+
+        for (uint pageCounter = 0; pageCounter < table2->blockCount; pageCounter++)
+        {
+            Page page = bufferManager.getPage(table2->tableName, pageCounter, false);
+            for (auto &row1 : chunkRows)
+                for (uint rowCounter = 0; rowCounter < table2->rowsPerBlockCount[pageCounter]; rowCounter++)
+                    this->insertNewRow(row1, page.getRowReference(rowCounter), rows);
+        }
+    }
+
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
 
-    // Comparator for Priority Queue
-    auto cmpPQ = [this, columnIndices, sortStrategyList](pair<vector<int>, int> &a, pair<vector<int>, int> &b) {
-        for(int i = 0; i < columnIndices.size(); i++) {
-            if(sortStrategyList[i] == ASC) {
-                if(a.first[columnIndices[i]] > b.first[columnIndices[i]]) return true;
-                if(a.first[columnIndices[i]] < b.first[columnIndices[i]]) return false;
+/**
+ * @brief Finds positions in a table sorted in ascending order on columnIndex:
+ * find(key) returns the number of rows whose key is below key (or, if
+ * strict, not above key). Keys must be looked up in ascending order, so the
+ * table is only ever read forwards, one page at a time.
+ *
+ */
+struct SortedTableSearch
+{
+    Table *table;
+    int columnIndex;
+    bool strict;
+    uint pageIndex = 0;
+    uint rowIndex = 0;
+    long long int position = 0;
+    bool pageLoaded = false;
+    Page page;
+
+    SortedTableSearch(Table *table, int columnIndex, bool strict) : table(table), columnIndex(columnIndex), strict(strict) {}
+
+    long long int find(int key)
+    {
+        for (; this->pageIndex < this->table->blockCount; this->pageIndex++, this->rowIndex = 0, this->pageLoaded = false)
+        {
+            if (!this->pageLoaded)
+            {
+                this->page = bufferManager.getPage(this->table->tableName, this->pageIndex, false);
+                this->pageLoaded = true;
             }
-            else {
-                if(a.first[columnIndices[i]] > b.first[columnIndices[i]]) return false;
-                if(a.first[columnIndices[i]] < b.first[columnIndices[i]]) return true;
+            for (; this->rowIndex < this->table->rowsPerBlockCount[this->pageIndex]; this->rowIndex++, this->position++)
+            {
+                int value = this->page.getRowReference(this->rowIndex)[this->columnIndex];
+                if (this->strict ? value > key : value >= key)
+                    return this->position;
             }
         }
-        return true;
+        return this->position;
+    }
+};
+
+/**
+ * @brief Join on <, <=, >, >= or != of two tables sorted in ascending order
+ * on their join columns. With table2 sorted, the rows matching a row of
+ * table1 are one contiguous range of table2 (two for !=), bounded by the
+ * positions of the first row of table2 whose key is not below the key of the
+ * row and of the first whose key is above it. As table1 is sorted too, those
+ * positions only move forwards and are found with a single pass over table2.
+ *
+ * Rows of table1 are then taken a memory load at a time and table2 is read
+ * once per load, over the pages that some range of the load overlaps. Each
+ * page is paired with the part of every range falling on it, so no pair of
+ * rows is ever compared, the output is written out in bulk.
+ *
+ * @param table1 
+ * @param table2 
+ * @param joinFirstColumnIndex 
+ * @param joinSecondColumnIndex 
+ * @param joinBinaryOperator 
+ */
+void Table::inequalityJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, BinaryOperator joinBinaryOperator)
+{
+    logger.log("Table::inequalityJoinTable");
+
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+
+    vector<long long int> firstPositions(table2->blockCount + 1, 0);
+    for (uint pageCounter = 0; pageCounter < table2->blockCount; pageCounter++)
+        firstPositions[pageCounter + 1] = firstPositions[pageCounter] + table2->rowsPerBlockCount[pageCounter];
+    long long int table2RowCount = firstPositions[table2->blockCount];
+
+    SortedTableSearch lowerSearch(table2, joinSecondColumnIndex, false);
+    SortedTableSearch upperSearch(table2, joinSecondColumnIndex, true);
+
+    // Matching rows of table2 for a row of table1, as up to two ranges of
+    // positions [first, last)
+    struct MatchRanges
+    {
+        long long int ranges[2][2];
+    };
+
+    vector<vector<int>> rows;
+    uint chunkPageCount = memoryFrames(2);
+    vector<vector<int>> chunkRows;
+    vector<MatchRanges> chunkRanges;
+    for (uint firstPageIndex = 0; firstPageIndex < table1->blockCount; firstPageIndex += chunkPageCount)
+    {
+        chunkRows.clear();
+        chunkRanges.clear();
+        long long int firstNeeded = table2RowCount, lastNeeded = 0;
+        for (uint pageCounter = firstPageIndex; pageCounter < min(table1->blockCount, firstPageIndex + chunkPageCount); pageCounter++)
+        {
+            Page page = bufferManager.getPage(table1->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < table1->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                const vector<int> &row = page.getRowReference(rowCounter);
+                int key = row[joinFirstColumnIndex];
+                long long int lower = lowerSearch.find(key);
+                long long int upper = upperSearch.find(key);
+
+                MatchRanges matchRanges = {{{0, 0}, {0, 0}}};
+                if (joinBinaryOperator == LESS_THAN)
+                    matchRanges.ranges[0][0] = upper, matchRanges.ranges[0][1] = table2RowCount;
+                else if (joinBinaryOperator == LEQ)
+                    matchRanges.ranges[0][0] = lower, matchRanges.ranges[0][1] = table2RowCount;
+                else if (joinBinaryOperator == GREATER_THAN)
+                    matchRanges.ranges[0][1] = lower;
+                else if (joinBinaryOperator == GEQ)
+                    matchRanges.ranges[0][1] = upper;
+                else
+                {
+                    matchRanges.ranges[0][1] = lower;
+                    matchRanges.ranges[1][0] = upper, matchRanges.ranges[1][1] = table2RowCount;
+                }
+
+                for (auto &range : matchRanges.ranges)
+                {
+                    if (range[0] >= range[1])
+                        continue;
+                    firstNeeded = min(firstNeeded, range[0]);
+                    lastNeeded = max(lastNeeded, range[1]);
+                }
+                chunkRows.push_back(row);
+                chunkRanges.push_back(matchRanges);
+            }
+        }
+
+        for (uint pageCounter = 0; pageCounter < table2->blockCount; pageCounter++)
+        {
+            long long int pageFirst = firstPositions[pageCounter], pageLast = firstPositions[pageCounter + 1];
+            if (pageLast <= firstNeeded || pageFirst >= lastNeeded)
+                continue;
+            Page page = bufferManager.getPage(table2->tableName, pageCounter, false);
+            for (uint chunkRowCounter = 0; chunkRowCounter < chunkRows.size(); chunkRowCounter++)
+            {
+                for (auto &range : chunkRanges[chunkRowCounter].ranges)
+                {
+                    long long int first = max(range[0], pageFirst), last = min(range[1], pageLast);
+                    for (long long int position = first; position < last; position++)
+                        this->insertNewRow(chunkRows[chunkRowCounter], page.getRowReference(position - pageFirst), rows);
+                }
+            }
+        }
+    }
+
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
+
+/**
+ * @brief Builds an index on columnName with one scan of the table. The entries,
+ * one per row, are written to a relation of their own, "$index_<table>", and
+ * sorted on the key with the external sort, so the index takes no memory
+ * beyond the buffer pool however large the table is. Only the first key of
+ * every index page is kept in memory (indexFenceKeys), which narrows a lookup
+ * down to the index pages that can hold the key. The same sorted index serves
+ * BTREE and HASH, NOTHING drops it.
+ *
+ * @param columnName 
+ * @param indexingStrategy 
+ */
+void Table::buildIndex(string columnName, IndexingStrategy indexingStrategy)
+{
+    logger.log("Table::buildIndex");
+    this->dropIndex();
+    this->indexed = (indexingStrategy != NOTHING);
+    this->indexedColumn = this->indexed ? columnName : "";
+    this->indexingStrategy = indexingStrategy;
+    if (!this->indexed)
+        return;
+
+    Table *indexTable = new Table("$index_" + this->tableName);
+    indexTable->columns = {"key", "pageIndex", "rowIndex"};
+    indexTable->columnCount = indexTable->columns.size();
+    indexTable->maxRowsPerBlock = (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * indexTable->columnCount));
+    tableCatalogue.insertTable(indexTable);
+    this->indexTableName = indexTable->tableName;
+
+    int columnIndex = this->getColumnIndex(columnName);
+    vector<vector<int>> rows;
+    for (uint pageCounter = 0; pageCounter < this->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(this->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < this->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            rows.push_back({page.getRowReference(rowCounter)[columnIndex], (int)pageCounter, (int)rowCounter});
+            if (rows.size() == indexTable->maxRowsPerBlock)
+            {
+                indexTable->writePage(indexTable->blockCount, rows, rows.size());
+                rows.clear();
+            }
+        }
+    }
+    if (!rows.empty())
+        indexTable->writePage(indexTable->blockCount, rows, rows.size());
+    indexTable->rowCount = this->rowCount;
+    indexTable->sortTable({0}, {ASC});
+
+    for (uint pageCounter = 0; pageCounter < indexTable->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(indexTable->tableName, pageCounter, false);
+        this->indexFenceKeys.push_back(page.getRowReference(0)[0]);
+    }
+}
+
+/**
+ * @brief Deletes the index relation of the table, if it has one.
+ *
+ */
+void Table::dropIndex()
+{
+    logger.log("Table::dropIndex");
+    if (!this->indexTableName.empty())
+        tableCatalogue.deleteTable(this->indexTableName);
+    this->indexTableName = "";
+    this->indexFenceKeys.clear();
+}
+
+/**
+ * @brief Index nested loop equi-join of outerTable with indexedTable on its
+ * indexed column. The outer relation is read a memory load at a time and its
+ * rows are sorted on the join key, so the batch walks the index relation
+ * forwards, using the fence keys to skip the index pages between keys. The
+ * matching index entries of the whole batch are then sorted by position, so
+ * each page of indexedTable is read at most once per batch, in page order.
+ *
+ * @param outerTable 
+ * @param indexedTable 
+ * @param outerColumnIndex 
+ * @param outerIsFirst whether outerTable is the first relation of the join
+ */
+void Table::indexJoinTable(Table *outerTable, Table *indexedTable, int outerColumnIndex, bool outerIsFirst)
+{
+    logger.log("Table::indexJoinTable");
+
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+
+    vector<vector<int>> rows;
+    uint batchPageCount = memoryFrames(3);
+    vector<vector<int>> outerRows;
+    vector<pair<int, uint>> outerKeys;
+    vector<pair<IndexEntry, uint>> probes;
+
+    Table *indexTable = tableCatalogue.getTable(indexedTable->indexTableName);
+    const vector<int> &fenceKeys = indexedTable->indexFenceKeys;
+    Page indexPage;
+    uint loadedIndexPage = UINT_MAX;
+    auto indexEntry = [&](uint pageIndex, uint rowIndex) -> const vector<int> & {
+        if (pageIndex != loadedIndexPage)
+        {
+            indexPage = bufferManager.getPage(indexTable->tableName, pageIndex, false);
+            loadedIndexPage = pageIndex;
+        }
+        return indexPage.getRowReference(rowIndex);
     };
+    for (uint firstPageIndex = 0; firstPageIndex < outerTable->blockCount; firstPageIndex += batchPageCount)
+    {
+        outerRows.clear();
+        outerKeys.clear();
+        for (uint pageCounter = firstPageIndex; pageCounter < min(outerTable->blockCount, firstPageIndex + batchPageCount); pageCounter++)
+        {
+            Page page = bufferManager.getPage(outerTable->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < outerTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                outerRows.push_back(page.getRowReference(rowCounter));
+                outerKeys.push_back({outerRows.back()[outerColumnIndex], outerRows.size() - 1});
+            }
+        }
+        sort(outerKeys.begin(), outerKeys.end());
+
+        probes.clear();
+        uint indexPageIndex = 0, indexRowIndex = 0;
+        for (auto &outerKey : outerKeys)
+        {
+            // The key can only start in the last index page whose fence key
+            // is below it, or in the first page if there is none
+            uint firstPageIndex = lower_bound(fenceKeys.begin(), fenceKeys.end(), outerKey.first) - fenceKeys.begin();
+            firstPageIndex = (firstPageIndex > 0) ? firstPageIndex - 1 : 0;
+            if (firstPageIndex > indexPageIndex)
+            {
+                indexPageIndex = firstPageIndex;
+                indexRowIndex = 0;
+            }
+            while (indexPageIndex < indexTable->blockCount && indexEntry(indexPageIndex, indexRowIndex)[0] < outerKey.first)
+            {
+                if (++indexRowIndex == indexTable->rowsPerBlockCount[indexPageIndex])
+                {
+                    indexPageIndex++;
+                    indexRowIndex = 0;
+                }
+            }
+            for (uint pageIndex = indexPageIndex, rowIndex = indexRowIndex; pageIndex < indexTable->blockCount;)
+            {
+                const vector<int> &entry = indexEntry(pageIndex, rowIndex);
+                if (entry[0] != outerKey.first)
+                    break;
+                probes.push_back({{entry[0], (uint)entry[1], (uint)entry[2]}, outerKey.second});
+                if (++rowIndex == indexTable->rowsPerBlockCount[pageIndex])
+                {
+                    pageIndex++;
+                    rowIndex = 0;
+                }
+            }
+        }
+        sort(probes.begin(), probes.end(), [](const pair<IndexEntry, uint> &a, const pair<IndexEntry, uint> &b) {
+            return make_pair(a.first.pageIndex, a.first.rowIndex) < make_pair(b.first.pageIndex, b.first.rowIndex);
+        });
+
+        for (uint probeCounter = 0; probeCounter < probes.size();)
+        {
+            uint pageIndex = probes[probeCounter].first.pageIndex;
+            Page page = bufferManager.getPage(indexedTable->tableName, pageIndex, false);
+            for (; probeCounter < probes.size() && probes[probeCounter].first.pageIndex == pageIndex; probeCounter++)
+            {
+                const vector<int> &indexedRow = page.getRowReference(probes[probeCounter].first.rowIndex);
+                const vector<int> &outerRow = outerRows[probes[probeCounter].second];
+                if (outerIsFirst)
+                    this->insertNewRow(outerRow, indexedRow, rows);
+                else
+                    this->insertNewRow(indexedRow, outerRow, rows);
+            }
+        }
+    }
+
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
+
+void Table::insertNewRow(const vector<int> &row1, const vector<int> &row2, vector<vector<int>> &rows) {
+    vector<int> currentRow;
+    currentRow.insert(currentRow.end(), row1.begin(), row1.end());
+    currentRow.insert(currentRow.end(), row2.begin(), row2.end());
+    rows.push_back(currentRow);
+    this->updateStatistics(currentRow);
 
-    vector<uint> prefix = {0};
-    for(int c: rowsPerBlockCount) {
-        prefix.push_back(prefix.back() + c);  
+    if(rows.size() == this->maxRowsPerBlock) {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
     }
+}
+
+/**
+ * @brief Equi-join of two tables sorted in ascending order on their join
+ * columns with a sort-merge join. Both tables are read forwards once. For
+ * every key found on both sides, the whole group of rows with that key is
+ * read from the smaller relation into memory and the group of the other
+ * relation is streamed against it, so many-to-many keys produce every pair.
+ *
+ * The group gets all buffer frames but the two input frames and the output
+ * frame. A group that outgrows them is spilled to a temporary relation, and
+ * the streamed group is then read a memory load at a time, each load being
+ * paired with every page of the spilled group. Result rows are written out a
+ * page at a time.
+ *
+ * @param table1 
+ * @param table2 
+ * @param joinFirstColumnIndex 
+ * @param joinSecondColumnIndex 
+ */
+void Table::joinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex) {
+    logger.log("Table::joinTable");
+    
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    if (table1->rowCount == 0 || table2->rowCount == 0)
+        return;
+
+    bool bufferFirst = make_pair(table1->blockCount, table1->rowCount) <= make_pair(table2->blockCount, table2->rowCount);
+    Table *bufferTable = bufferFirst ? table1 : table2;
+    Table *streamTable = bufferFirst ? table2 : table1;
+    int bufferColumnIndex = bufferFirst ? joinFirstColumnIndex : joinSecondColumnIndex;
+    int streamColumnIndex = bufferFirst ? joinSecondColumnIndex : joinFirstColumnIndex;
+
+    RunReader bufferReader({bufferTable, 0, bufferTable->blockCount, bufferTable->rowCount});
+    RunReader streamReader({streamTable, 0, streamTable->blockCount, streamTable->rowCount});
+    uint memoryPageCount = memoryFrames(3);
+    size_t groupRowLimit = (size_t)memoryPageCount * bufferTable->maxRowsPerBlock;
+    size_t streamRowLimit = (size_t)memoryPageCount * streamTable->maxRowsPerBlock;
+
+    vector<vector<int>> rows;
+    auto addPair = [&](const vector<int> &bufferRow, const vector<int> &streamRow) {
+        if (bufferFirst)
+            this->insertNewRow(bufferRow, streamRow, rows);
+        else
+            this->insertNewRow(streamRow, bufferRow, rows);
+    };
+
+    vector<vector<int>> group, streamRows;
+    Table *spillTable = nullptr;
+    uint spillPageCount = 0;
+    while (bufferReader.rowsRemaining > 0 && streamReader.rowsRemaining > 0)
+    {
+        int key = bufferReader.currentRow()[bufferColumnIndex];
+        int streamKey = streamReader.currentRow()[streamColumnIndex];
+        if (key < streamKey)
+        {
+            bufferReader.advance();
+            continue;
+        }
+        if (streamKey < key)
+        {
+            streamReader.advance();
+            continue;
+        }
+
+        // Read the group of the buffered relation, spilling it a page at a
+        // time once it no longer fits
+        group.clear();
+        bool spilled = false;
+        if (spillTable)
+        {
+            spillTable->blockCount = 0;
+            spillTable->rowsPerBlockCount.clear();
+        }
+        while (bufferReader.rowsRemaining > 0 && bufferReader.currentRow()[bufferColumnIndex] == key)
+        {
+            group.push_back(bufferReader.currentRow());
+            bufferReader.advance();
+            bool groupContinues = bufferReader.rowsRemaining > 0 && bufferReader.currentRow()[bufferColumnIndex] == key;
+            if ((group.size() == (spilled ? bufferTable->maxRowsPerBlock : groupRowLimit) && groupContinues) || (spilled && !groupContinues))
+            {
+                if (!spillTable)
+                    spillTable = bufferTable->createRunTable("$mergeGroup_" + this->tableName);
+                for (uint firstRow = 0; firstRow < group.size(); firstRow += bufferTable->maxRowsPerBlock)
+                {
+                    vector<vector<int>> pageRows(group.begin() + firstRow, group.begin() + min((uint)group.size(), firstRow + bufferTable->maxRowsPerBlock));
+                    spillTable->writePage(spillTable->blockCount, pageRows, pageRows.size());
+                }
+                group.clear();
+                spilled = true;
+            }
+        }
 
+        if (!spilled)
+        {
+            for (; streamReader.rowsRemaining > 0 && streamReader.currentRow()[streamColumnIndex] == key; streamReader.advance())
+                for (auto &bufferRow : group)
+                    addPair(bufferRow, streamReader.currentRow());
+            continue;
+        }
 
-    for(int level = 0; level < totalLevels; level++) {
-        int tempPageIndex = 0;
-        for(int i = 0; i < blockCount; i += pow(3, level + 1)) {
+        spillPageCount = max(spillPageCount, spillTable->blockCount);
+        while (streamReader.rowsRemaining > 0 && streamReader.currentRow()[streamColumnIndex] == key)
+        {
+            streamRows.clear();
+            for (; streamRows.size() < streamRowLimit && streamReader.rowsRemaining > 0 && streamReader.currentRow()[streamColumnIndex] == key; streamReader.advance())
+                streamRows.push_back(streamReader.currentRow());
+            for (uint pageCounter = 0; pageCounter < spillTable->blockCount; pageCounter++)
+            {
+                Page page = bufferManager.getPage(spillTable->tableName, pageCounter, false);
+                for (auto &streamRow : streamRows)
+                    for (uint rowCounter = 0; rowCounter < spillTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+                        addPair(page.getRowReference(rowCounter), streamRow);
+            }
+        }
+    }
 
-            priority_queue<pair<vector<int>, int>, vector<pair<vector<int>, int>>, decltype(cmpPQ)> pq(cmpPQ);
-            
-            vector<Cursor> cursorPool;
-            vector<int> recordsToProcessed;
-            int idx = 0;
+    if (spillTable)
+    {
+        // Pages of earlier, larger groups are past blockCount
+        spillTable->blockCount = spillPageCount;
+        spillTable->rowsPerBlockCount.resize(spillPageCount, 0);
+        tableCatalogue.deleteTable(spillTable->tableName);
+    }
 
-            int jump = pow(3, level);
-            for(int j = i; j < i + pow(3, level + 1) && j < blockCount; j += jump) {
-                int left = j;
-                int right = min(j + jump, (int)blockCount);
-                int nRecords = prefix[right] - prefix[left];
-                recordsToProcessed.push_back(nRecords);
-                // cout << left << " " << right << " " << nRecords << "\n";
+    if(rows.size() > 0) {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
 
-                Cursor cursor(this->tableName, j);
-                cursorPool.push_back(cursor);
-                pq.push({cursorPool[idx].getNext(), idx});
-                recordsToProcessed[idx]--;
-                idx++;
-            }
+/**
+ * @brief Hash of a join or grouping key. Each level of recursive partitioning
+ * uses a different seed, so that rows that collided in one partition are
+ * spread out at the next level.
+ *
+ * @param key 
+ * @param level 
+ * @return unsigned long long 
+ */
+unsigned long long hashJoinKey(int key, int level)
+{
+    unsigned long long hash = ((unsigned long long)(uint32_t)key + 1) * 0x9E3779B97F4A7C15ULL + (unsigned long long)level * 0xD1B54A32D192ED03ULL;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
 
-            vector<vector<int>> rows;
-            while(!pq.empty()) {
-                auto [row, idx] = pq.top();
-                pq.pop();
+BloomFilter::BloomFilter(long long int keyCount)
+{
+    this->bitCount = max(64ULL, (unsigned long long)keyCount * 10);
+    this->words.assign((this->bitCount + 63) / 64, 0);
+}
 
-                rows.push_back(row);
+/**
+ * @brief The hashCount bit positions of a key are derived from a single hash
+ * by double hashing. The hash is seeded apart from the partitioning levels of
+ * the hash join, so the filter stays independent of the partition a key falls
+ * in.
+ *
+ * @param key 
+ */
+void BloomFilter::insert(int key)
+{
+    unsigned long long hash = hashJoinKey(key, -1);
+    unsigned long long step = (hash >> 32) | 1;
+    for (int hashCounter = 0; hashCounter < this->hashCount; hashCounter++, hash += step)
+        this->words[(hash % this->bitCount) >> 6] |= 1ULL << ((hash % this->bitCount) & 63);
+}
 
-                if(rows.size() == maxRowsPerBlock) {
-                    bufferManager.writePage("$sortTemp_" + tableName, tempPageIndex, rows, rows.size());
-                    tempPageIndex++;
-                    rows.clear();
-                }
+bool BloomFilter::mayContain(int key) const
+{
+    unsigned long long hash = hashJoinKey(key, -1);
+    unsigned long long step = (hash >> 32) | 1;
+    for (int hashCounter = 0; hashCounter < this->hashCount; hashCounter++, hash += step)
+        if (!(this->words[(hash % this->bitCount) >> 6] & (1ULL << ((hash % this->bitCount) & 63))))
+            return false;
+    return true;
+}
 
-                if(recordsToProcessed[idx] > 0) {
-                    pq.push({cursorPool[idx].getNext(), idx});
-                    recordsToProcessed[idx]--;
-                }
-            }
+/**
+ * @brief Adds the keys of another filter of the same size, so that threads can
+ * fill filters of their own and combine them afterwards.
+ *
+ * @param other 
+ */
+void BloomFilter::merge(const BloomFilter &other)
+{
+    for (size_t wordCounter = 0; wordCounter < this->words.size(); wordCounter++)
+        this->words[wordCounter] |= other.words[wordCounter];
+    this->eliminatedRowCount += other.eliminatedRowCount;
+}
 
-            if(!rows.empty()) {
-                bufferManager.writePage("$sortTemp_" + tableName, tempPageIndex, rows, rows.size());
-                tempPageIndex++;
-                rows.clear();
-            }
-        }
-        for(int i = 0; i < blockCount; i++) {
-            bufferManager.renameFile("$sortTemp_" + tableName, tableName, i);
+/**
+ * @brief Estimates which combinations of values of the given columns occur at
+ * least rowThreshold times, from a sample of up to BLOCK_COUNT - 2 pages
+ * spread evenly over the table. Hash based operators route such heavy hitters
+ * around their partitions.
+ *
+ * @param columnIndices 
+ * @param rowThreshold 
+ * @return vector<vector<int>> 
+ */
+vector<vector<int>> Table::findHeavyGroupKeys(const vector<int> &columnIndices, long long int rowThreshold)
+{
+    logger.log("Table::findHeavyGroupKeys");
+    vector<vector<int>> heavyKeys;
+    uint samplePageCount = min(this->blockCount, memoryFrames(2));
+    if (samplePageCount == 0)
+        return heavyKeys;
+
+    unordered_map<vector<int>, long long int, GroupKeyHash> sampleCounts;
+    vector<int> key(columnIndices.size());
+    for (uint sampleCounter = 0; sampleCounter < samplePageCount; sampleCounter++)
+    {
+        uint pageIndex = (unsigned long long)sampleCounter * this->blockCount / samplePageCount;
+        Page page = bufferManager.getPage(this->tableName, pageIndex, false);
+        for (uint rowCounter = 0; rowCounter < this->rowsPerBlockCount[pageIndex]; rowCounter++)
+        {
+            const vector<int> &row = page.getRowReference(rowCounter);
+            for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+                key[columnCounter] = row[columnIndices[columnCounter]];
+            sampleCounts[key]++;
         }
     }
+    for (auto &sampleCount : sampleCounts)
+        if ((long double)sampleCount.second * this->blockCount / samplePageCount >= rowThreshold)
+            heavyKeys.push_back(sampleCount.first);
+    return heavyKeys;
 }
 
+/**
+ * @brief Heavy hitters of a single column (see findHeavyGroupKeys).
+ *
+ * @param columnIndex 
+ * @param rowThreshold 
+ * @return unordered_set<int> 
+ */
+unordered_set<int> Table::findHeavyKeys(int columnIndex, long long int rowThreshold)
+{
+    logger.log("Table::findHeavyKeys");
+    unordered_set<int> heavyKeys;
+    for (auto &heavyKey : this->findHeavyGroupKeys({columnIndex}, rowThreshold))
+        heavyKeys.insert(heavyKey[0]);
+    return heavyKeys;
+}
+
+/**
+ * @brief Equi-join of table1 and table2 with a hybrid hash join (see
+ * hashJoinPartition). The smaller relation, by blockCount and then rowCount,
+ * is the build side. Rows are written as the row of table1 followed by the row
+ * of table2 whichever side is built.
+ *
+ * When the probe side is BLOOM_FILTER_RATIO times larger, the build keys are
+ * also added to a Bloom filter sized from the number of distinct build keys,
+ * and probe rows that fail it are dropped before they are partitioned or
+ * looked up. The number of rows it eliminated is logged.
+ *
+ * With more than one thread (THREAD_COUNT), a probe side larger than the
+ * memory of one thread is joined in parallel (see parallelHashJoinTable).
+ *
+ * @param table1 
+ * @param table2 
+ * @param joinFirstColumnIndex 
+ * @param joinSecondColumnIndex 
+ */
+void Table::hashJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex)
+{
+    logger.log("Table::hashJoinTable");
 
-void Table::groupTable(Table* tempTable, int groupColumnIndex, BinaryOperator groupBinaryOperator, int groupAggregateColumnValue, string groupAggregateFunction, int groupAggregateColumnIndex, string groupReturnAggregateFunction, int groupReturnAggregateColumnIndex) {
-    logger.log("Table::groupTable");
-    
     this->distinctValuesInColumns.assign(this->columnCount, {});
     this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
-    
-    vector<vector<int>> rows;
 
-    Cursor cursor(tempTable->tableName, 0);
-    vector<int> row = cursor.getNext();
-
-    int prevColumnVal = row[groupColumnIndex];
-    int rowCount = 0;
-    int groupAggregateColumnRes = (groupAggregateFunction == "MIN") ? 1000 : 0;
-    int groupReturnAggregateColumnRes = (groupReturnAggregateFunction == "MIN") ? 1000 : 0;
+    vector<vector<int>> rows;
+    bool buildIsFirst = make_pair(table1->blockCount, table1->rowCount) <= make_pair(table2->blockCount, table2->rowCount);
+    Table *buildTable = buildIsFirst ? table1 : table2;
+    Table *probeTable = buildIsFirst ? table2 : table1;
+    int buildColumnIndex = buildIsFirst ? joinFirstColumnIndex : joinSecondColumnIndex;
+    int probeColumnIndex = buildIsFirst ? joinSecondColumnIndex : joinFirstColumnIndex;
+
+    unique_ptr<BloomFilter> filter;
+    if (probeTable->blockCount >= (unsigned long long)BLOOM_FILTER_RATIO * max(1u, buildTable->blockCount))
+    {
+        long long int keyCount = buildTable->rowCount;
+        if (buildColumnIndex < buildTable->distinctValuesPerColumnCount.size() && buildTable->distinctValuesPerColumnCount[buildColumnIndex] > 0)
+            keyCount = min(keyCount, (long long int)buildTable->distinctValuesPerColumnCount[buildColumnIndex]);
+        filter.reset(new BloomFilter(keyCount));
+    }
+    if (THREAD_COUNT > 1 && probeTable->blockCount > memoryFrames(2))
+        this->parallelHashJoinTable(buildTable, probeTable, buildColumnIndex, probeColumnIndex, buildIsFirst, filter.get());
+    else
+        this->hashJoinPartition(buildTable, probeTable, buildColumnIndex, probeColumnIndex, buildIsFirst, 0, memoryFrames(2), rows, filter.get());
+    if (filter)
+        logger.log("Table::hashJoinTable: Bloom filter on " + buildTable->tableName + " eliminated " + to_string(filter->eliminatedRowCount) + " of " + to_string(probeTable->rowCount) + " rows of " + probeTable->tableName);
+
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+}
 
-    while(!row.empty()) {
-        if(row[groupColumnIndex] != prevColumnVal) {
-            if(groupAggregateFunction == "AVG") {
-                groupAggregateColumnRes /= rowCount;
-            }
+/**
+ * @brief Hash join on up to THREAD_COUNT worker threads. Every task writes its
+ * result rows to an output relation of its own, whose pages are moved into
+ * this table once all tasks are done (see BufferManager::sharePage).
+ *
+ * A build side that fits in memory is loaded into a single hash table, which
+ * the workers probe read-only, each with its own range of probe pages and
+ * with an input and an output frame of the frames the hash table leaves.
+ *
+ * Otherwise the buffer pool is split evenly among the workers, and both sides
+ * are radix partitioned on the top bits of the key hash into as many
+ * partitions as one worker has frames, the workers each partitioning their
+ * own range of pages. A worker buffers a page per partition and appends full
+ * pages to the shared partition, taking the partition's lock only to claim the
+ * page index. Each pair of partitions is then joined as an independent task
+ * within one worker's frames (see hashJoinPartition), which partitions it
+ * further if it still doesn't fit and sets its heavy hitters apart.
+ *
+ * @param buildTable 
+ * @param probeTable 
+ * @param buildColumnIndex 
+ * @param probeColumnIndex 
+ * @param buildIsFirst whether buildTable is the first relation of the join
+ * @param filter if given, filled with the build keys and used to drop probe
+ * rows
+ */
+void Table::parallelHashJoinTable(Table *buildTable, Table *probeTable, int buildColumnIndex, int probeColumnIndex, bool buildIsFirst, BloomFilter *filter)
+{
+    logger.log("Table::parallelHashJoinTable");
+    uint memoryPageCount = memoryFrames(2);
+
+    vector<Table*> outputTables;
+    auto addOutputTable = [&]() {
+        outputTables.push_back(this->createRunTable("$joinOutput" + to_string(outputTables.size()) + "_" + this->tableName));
+        outputTables.back()->distinctValuesInColumns.assign(this->columnCount, {});
+        outputTables.back()->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    };
+    auto workerPageRange = [](Table *table, uint workerCount, uint workerCounter) {
+        return make_pair((uint)((unsigned long long)table->blockCount * workerCounter / workerCount),
+                         (uint)((unsigned long long)table->blockCount * (workerCounter + 1) / workerCount));
+    };
 
-            if(groupReturnAggregateFunction == "AVG") {
-                groupReturnAggregateColumnRes /= rowCount;
+    if (buildTable->blockCount <= memoryPageCount)
+    {
+        vector<vector<int>> buildRows;
+        unordered_multimap<int, uint> hashTable;
+        for (uint pageCounter = 0; pageCounter < buildTable->blockCount; pageCounter++)
+        {
+            Page page = bufferManager.getPage(buildTable->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < buildTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                buildRows.push_back(page.getRowReference(rowCounter));
+                hashTable.insert({buildRows.back()[buildColumnIndex], buildRows.size() - 1});
+                if (filter)
+                    filter->insert(buildRows.back()[buildColumnIndex]);
             }
+        }
 
-            if(groupBinaryOperator == LESS_THAN) {
-                if(groupAggregateColumnRes < groupAggregateColumnValue) {
-                    rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-                    this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+        uint workerCount = max(1u, min({THREAD_COUNT, probeTable->blockCount / memoryPageCount, (memoryPageCount + 2 - buildTable->blockCount) / 2}));
+        vector<long long int> eliminatedRowCounts(workerCount, 0);
+        for (uint workerCounter = 0; workerCounter < workerCount; workerCounter++)
+            addOutputTable();
+        parallelFor(workerCount, [&](uint workerCounter) {
+            Table *outputTable = outputTables[workerCounter];
+            vector<vector<int>> rows;
+            auto pageRange = workerPageRange(probeTable, workerCount, workerCounter);
+            for (uint pageCounter = pageRange.first; pageCounter < pageRange.second; pageCounter++)
+            {
+                Page page = bufferManager.getPage(probeTable->tableName, pageCounter, false);
+                for (uint rowCounter = 0; rowCounter < probeTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+                {
+                    const vector<int> &probeRow = page.getRowReference(rowCounter);
+                    if (filter && !filter->mayContain(probeRow[probeColumnIndex]))
+                    {
+                        eliminatedRowCounts[workerCounter]++;
+                        continue;
+                    }
+                    auto matches = hashTable.equal_range(probeRow[probeColumnIndex]);
+                    for (auto match = matches.first; match != matches.second; match++)
+                    {
+                        if (buildIsFirst)
+                            outputTable->insertNewRow(buildRows[match->second], probeRow, rows);
+                        else
+                            outputTable->insertNewRow(probeRow, buildRows[match->second], rows);
+                    }
                 }
             }
-            else if(groupBinaryOperator == LEQ) {
-                if(groupAggregateColumnRes <= groupAggregateColumnValue) {
-                    rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-                    this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
-                }
+            if (!rows.empty())
+                outputTable->writePage(outputTable->blockCount, rows, rows.size());
+        });
+        if (filter)
+            for (long long int eliminatedRowCount : eliminatedRowCounts)
+                filter->eliminatedRowCount += eliminatedRowCount;
+    }
+    else
+    {
+        // Partition Phase
+        uint workerCount = max(1u, min(THREAD_COUNT, BLOCK_COUNT / 3));
+        uint workerPageCount = workerCount == 1 ? memoryPageCount : BLOCK_COUNT / workerCount - 2;
+        uint partitionBits = 1;
+        while ((2u << partitionBits) <= workerPageCount)
+            partitionBits++;
+        uint partitionCount = 1u << partitionBits;
+        vector<Table*> buildPartitions, probePartitions;
+        for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+        {
+            string partitionName = to_string(partitionCounter) + "_" + buildTable->tableName;
+            buildPartitions.push_back(buildTable->createRunTable("$parallelHashBuild" + partitionName));
+            probePartitions.push_back(probeTable->createRunTable("$parallelHashProbe" + partitionName));
+        }
+
+        vector<mutex> partitionMutexes(partitionCount);
+        auto appendPage = [&](Table *partition, uint partitionCounter, vector<vector<int>> &buffer) {
+            uint pageIndex;
+            {
+                lock_guard<mutex> lock(partitionMutexes[partitionCounter]);
+                pageIndex = partition->blockCount++;
+                partition->rowsPerBlockCount.push_back(buffer.size());
+                partition->rowCount += buffer.size();
             }
-            else if(groupBinaryOperator == GREATER_THAN) {
-                if(groupAggregateColumnRes > groupAggregateColumnValue) {
-                    rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-                    this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+            bufferManager.writePage(partition->tableName, pageIndex, buffer, buffer.size());
+            buffer.clear();
+        };
+        auto partitionTable = [&](Table *table, int columnIndex, vector<Table*> &partitions, bool isBuild) {
+            uint partitioningWorkerCount = max(1u, min(workerCount, table->blockCount / workerPageCount));
+            vector<unique_ptr<BloomFilter>> workerFilters(partitioningWorkerCount);
+            vector<long long int> eliminatedRowCounts(partitioningWorkerCount, 0);
+            parallelFor(partitioningWorkerCount, [&](uint workerCounter) {
+                // Build keys go to a filter of the worker's own, merged below
+                if (filter && isBuild)
+                    workerFilters[workerCounter].reset(new BloomFilter(*filter));
+                BloomFilter *workerFilter = workerFilters[workerCounter].get();
+                vector<vector<vector<int>>> buffers(partitionCount);
+                auto pageRange = workerPageRange(table, partitioningWorkerCount, workerCounter);
+                for (uint pageCounter = pageRange.first; pageCounter < pageRange.second; pageCounter++)
+                {
+                    Page page = bufferManager.getPage(table->tableName, pageCounter, false);
+                    for (uint rowCounter = 0; rowCounter < table->rowsPerBlockCount[pageCounter]; rowCounter++)
+                    {
+                        const vector<int> &row = page.getRowReference(rowCounter);
+                        if (workerFilter)
+                            workerFilter->insert(row[columnIndex]);
+                        else if (filter && !isBuild && !filter->mayContain(row[columnIndex]))
+                        {
+                            eliminatedRowCounts[workerCounter]++;
+                            continue;
+                        }
+                        uint partitionCounter = hashJoinKey(row[columnIndex], 0) >> (64 - partitionBits);
+                        buffers[partitionCounter].push_back(row);
+                        if (buffers[partitionCounter].size() == partitions[partitionCounter]->maxRowsPerBlock)
+                            appendPage(partitions[partitionCounter], partitionCounter, buffers[partitionCounter]);
+                    }
                 }
+                for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+                    if (!buffers[partitionCounter].empty())
+                        appendPage(partitions[partitionCounter], partitionCounter, buffers[partitionCounter]);
+            });
+            for (uint workerCounter = 0; workerCounter < partitioningWorkerCount; workerCounter++)
+            {
+                if (workerFilters[workerCounter])
+                    filter->merge(*workerFilters[workerCounter]);
+                if (filter)
+                    filter->eliminatedRowCount += eliminatedRowCounts[workerCounter];
             }
-            else if(groupBinaryOperator == GEQ) {
-                if(groupAggregateColumnRes >= groupAggregateColumnValue) {
-                    rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-                    this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
-                }
+        };
+        partitionTable(buildTable, buildColumnIndex, buildPartitions, true);
+        partitionTable(probeTable, probeColumnIndex, probePartitions, false);
+
+        // Join Phase, the smaller side of each pair of partitions is built
+        for (uint partitionCounter = 0; partitionCounter < partitionCount; partitionCounter++)
+            addOutputTable();
+        parallelFor(partitionCount, [&](uint partitionCounter) {
+            Table *outputTable = outputTables[partitionCounter];
+            Table *buildPartition = buildPartitions[partitionCounter];
+            Table *probePartition = probePartitions[partitionCounter];
+            vector<vector<int>> rows;
+            if (buildPartition->rowCount > 0 && probePartition->rowCount > 0)
+            {
+                if (make_pair(buildPartition->blockCount, buildPartition->rowCount) <= make_pair(probePartition->blockCount, probePartition->rowCount))
+                    outputTable->hashJoinPartition(buildPartition, probePartition, buildColumnIndex, probeColumnIndex, buildIsFirst, 1, workerPageCount, rows);
+                else
+                    outputTable->hashJoinPartition(probePartition, buildPartition, probeColumnIndex, buildColumnIndex, !buildIsFirst, 1, workerPageCount, rows);
             }
-            else {
-                if(groupAggregateColumnRes == groupAggregateColumnValue) {
-                    rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-                    this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+            if (!rows.empty())
+                outputTable->writePage(outputTable->blockCount, rows, rows.size());
+            tableCatalogue.deleteTable(buildPartition->tableName);
+            tableCatalogue.deleteTable(probePartition->tableName);
+        }, workerCount);
+    }
+
+    this->appendOutputTables(outputTables);
+}
+
+/**
+ * @brief Joins buildTable and probeTable on buildColumnIndex ==
+ * probeColumnIndex, adding the result rows through insertNewRow. The build
+ * side gets memoryPageCount frames, all of the caller's share of the buffer
+ * pool but one input and one output frame.
+ *
+ * A build side that fits is loaded into a hash table and the probe side is
+ * streamed against it. Otherwise the join is a hybrid hash join: just enough
+ * spilled partitions are made for each to fit in memory at the next level, and
+ * the frames left over keep a resident partition in memory, which is joined
+ * while the probe side is partitioned. If the resident partition outgrows its
+ * frames it is spilled as one more partition. The partly filled pages of the
+ * build partitions are written out before the probe side is read, so their
+ * frames are reused for the probe partitions. Every pair of spilled partitions
+ * is then joined recursively with a new hash seed.
+ *
+ * Partitioning can't split up a key that fills a partition by itself. Such
+ * heavy hitters are found from a sample of the build side (see findHeavyKeys)
+ * before partitioning, and their rows on both sides are set apart and joined
+ * with the build side a memory load at a time against a full scan of the
+ * probe side. The same nested loop ends the recursion past a few levels.
+ *
+ * @param buildTable 
+ * @param probeTable 
+ * @param buildColumnIndex 
+ * @param probeColumnIndex 
+ * @param buildIsFirst whether buildTable is the first relation of the join
+ * @param level recursion depth, used to seed the hash function
+ * @param memoryPageCount 
+ * @param rows output page buffer
+ * @param filter if given, filled with the build keys and used to drop probe
+ * rows before they are partitioned or looked up
+ */
+void Table::hashJoinPartition(Table *buildTable, Table *probeTable, int buildColumnIndex, int probeColumnIndex, bool buildIsFirst, int level, uint memoryPageCount, vector<vector<int>> &rows, BloomFilter *filter)
+{
+    logger.log("Table::hashJoinPartition");
+    const int MAX_PARTITIONING_LEVEL = 3;
+
+    auto emit = [&](const vector<int> &buildRow, const vector<int> &probeRow) {
+        if (buildIsFirst)
+            this->insertNewRow(buildRow, probeRow, rows);
+        else
+            this->insertNewRow(probeRow, buildRow, rows);
+    };
+
+    vector<vector<int>> buildRows;
+    unordered_multimap<int, uint> hashTable;
+    auto probeAll = [&]() {
+        for (uint pageCounter = 0; pageCounter < probeTable->blockCount; pageCounter++)
+        {
+            Page page = bufferManager.getPage(probeTable->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < probeTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                const vector<int> &probeRow = page.getRowReference(rowCounter);
+                if (filter && !filter->mayContain(probeRow[probeColumnIndex]))
+                {
+                    filter->eliminatedRowCount++;
+                    continue;
                 }
+                auto matches = hashTable.equal_range(probeRow[probeColumnIndex]);
+                for (auto match = matches.first; match != matches.second; match++)
+                    emit(buildRows[match->second], probeRow);
             }
+        }
+    };
 
-            if(rows.size() == this->maxRowsPerBlock) {
-                bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
-                this->blockCount++;
-                this->rowsPerBlockCount.emplace_back(rows.size());
-                rows.clear();
+    if (buildTable->blockCount <= memoryPageCount || level >= MAX_PARTITIONING_LEVEL)
+    {
+        // In memory join, a memory load of the build side at a time
+        for (uint firstPageIndex = 0; firstPageIndex < buildTable->blockCount; firstPageIndex += memoryPageCount)
+        {
+            buildRows.clear();
+            hashTable.clear();
+            for (uint pageCounter = firstPageIndex; pageCounter < min(buildTable->blockCount, firstPageIndex + memoryPageCount); pageCounter++)
+            {
+                Page page = bufferManager.getPage(buildTable->tableName, pageCounter, false);
+                for (uint rowCounter = 0; rowCounter < buildTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+                {
+                    buildRows.push_back(page.getRowReference(rowCounter));
+                    hashTable.insert({buildRows.back()[buildColumnIndex], buildRows.size() - 1});
+                    if (filter)
+                        filter->insert(buildRows.back()[buildColumnIndex]);
+                }
             }
-            
-            prevColumnVal = row[groupColumnIndex];
-            rowCount = 0;
-            groupAggregateColumnRes = (groupAggregateFunction == "MIN") ? 1000 : 0;
-            groupReturnAggregateColumnRes = (groupReturnAggregateFunction == "MIN") ? 1000 : 0;
+            probeAll();
         }
+        return;
+    }
 
-        if(groupAggregateFunction == "MAX") {
-            groupAggregateColumnRes = max(groupAggregateColumnRes, row[groupAggregateColumnIndex]);
-        }
-        else if(groupAggregateFunction == "MIN") {
-            groupAggregateColumnRes = min(groupAggregateColumnRes, row[groupAggregateColumnIndex]);
-        }
-        else {
-            groupAggregateColumnRes += row[groupAggregateColumnIndex];
+    // Each spilled partition should fit in memory, each needs an output frame
+    // and the resident partition gets whatever frames are left
+    uint spilledPartitionCount = min(max(1u, memoryPageCount - 1), (buildTable->blockCount + memoryPageCount - 1) / memoryPageCount);
+    uint residentPageCount = memoryPageCount - min(memoryPageCount, spilledPartitionCount);
+    unsigned long long residentThreshold = (unsigned long long)(((long double)residentPageCount / buildTable->blockCount) * 4294967296.0L);
+    uint residentRowCapacity = residentPageCount * buildTable->maxRowsPerBlock;
+    bool residentSpilled = (residentPageCount == 0);
+
+    string partitionSuffix = to_string(level) + "_" + buildTable->tableName;
+    vector<Table*> buildPartitions, probePartitions;
+    vector<vector<vector<int>>> buildBuffers, probeBuffers;
+    auto addPartition = [&]() {
+        string partitionName = to_string(buildPartitions.size()) + "_" + partitionSuffix;
+        buildPartitions.push_back(buildTable->createRunTable("$hashBuild" + partitionName));
+        probePartitions.push_back(probeTable->createRunTable("$hashProbe" + partitionName));
+        buildBuffers.emplace_back();
+        probeBuffers.emplace_back();
+    };
+    auto appendRow = [](Table *partition, vector<vector<int>> &buffer, const vector<int> &row) {
+        buffer.push_back(row);
+        partition->rowCount++;
+        if (buffer.size() == partition->maxRowsPerBlock)
+        {
+            partition->writePage(partition->blockCount, buffer, buffer.size());
+            buffer.clear();
         }
+    };
+    auto flushBuffer = [](Table *partition, vector<vector<int>> &buffer) {
+        if (!buffer.empty())
+            partition->writePage(partition->blockCount, buffer, buffer.size());
+        vector<vector<int>>().swap(buffer);
+    };
+    for (uint partitionCounter = 0; partitionCounter < spilledPartitionCount; partitionCounter++)
+        addPartition();
+    uint residentOverflowPartition = residentSpilled ? 0 : spilledPartitionCount;
+
+    // Keys that fill half a partition by themselves can't be split up by
+    // partitioning again. Their rows bypass the partitions and are joined
+    // apart, a memory load of build rows at a time
+    unordered_set<int> heavyKeys = buildTable->findHeavyKeys(buildColumnIndex, (long long int)memoryPageCount * buildTable->maxRowsPerBlock / 2);
+    Table *heavyBuildTable = nullptr, *heavyProbeTable = nullptr;
+    vector<vector<int>> heavyBuildBuffer, heavyProbeBuffer;
+    if (!heavyKeys.empty())
+    {
+        LOG_DEBUG("Table::hashJoinPartition: " + to_string(heavyKeys.size()) + " heavy keys in " + buildTable->tableName);
+        heavyBuildTable = buildTable->createRunTable("$hashHeavyBuild" + partitionSuffix);
+        heavyProbeTable = probeTable->createRunTable("$hashHeavyProbe" + partitionSuffix);
+    }
 
-        if(groupReturnAggregateFunction == "MAX") {
-            groupReturnAggregateColumnRes = max(groupReturnAggregateColumnRes, row[groupReturnAggregateColumnIndex]);
-        }
-        else if(groupReturnAggregateFunction == "MIN") {
-            groupReturnAggregateColumnRes = min(groupReturnAggregateColumnRes, row[groupReturnAggregateColumnIndex]);
-        }
-        else {
-            groupReturnAggregateColumnRes += row[groupReturnAggregateColumnIndex];
-        }
-        
-        rowCount++;
+    // Partition index of a key, or -1 for the resident partition
+    auto partitionOf = [&](int key) {
+        unsigned long long hash = hashJoinKey(key, level);
+        if ((hash >> 32) < residentThreshold)
+            return residentSpilled ? (int)residentOverflowPartition : -1;
+        return (int)((hash & 0xffffffffULL) % spilledPartitionCount);
+    };
 
-        row = cursor.getNext();
+    for (uint pageCounter = 0; pageCounter < buildTable->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(buildTable->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < buildTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            const vector<int> &buildRow = page.getRowReference(rowCounter);
+            if (filter)
+                filter->insert(buildRow[buildColumnIndex]);
+            if (heavyBuildTable && heavyKeys.count(buildRow[buildColumnIndex]))
+            {
+                appendRow(heavyBuildTable, heavyBuildBuffer, buildRow);
+                continue;
+            }
+            int partitionIndex = partitionOf(buildRow[buildColumnIndex]);
+            if (partitionIndex != -1)
+            {
+                appendRow(buildPartitions[partitionIndex], buildBuffers[partitionIndex], buildRow);
+                continue;
+            }
+            buildRows.push_back(buildRow);
+            if (buildRows.size() > residentRowCapacity)
+            {
+                addPartition();
+                residentSpilled = true;
+                for (auto &residentRow : buildRows)
+                    appendRow(buildPartitions[residentOverflowPartition], buildBuffers[residentOverflowPartition], residentRow);
+                buildRows.clear();
+            }
+        }
     }
+    for (uint rowCounter = 0; rowCounter < buildRows.size(); rowCounter++)
+        hashTable.insert({buildRows[rowCounter][buildColumnIndex], rowCounter});
 
-    if(groupAggregateFunction == "AVG") {
-        groupAggregateColumnRes /= rowCount;
-    }
+    // The build partitions are complete, their buffers make way for the probe
+    // partitions' buffers
+    for (uint partitionCounter = 0; partitionCounter < buildPartitions.size(); partitionCounter++)
+        flushBuffer(buildPartitions[partitionCounter], buildBuffers[partitionCounter]);
+    if (heavyBuildTable)
+        flushBuffer(heavyBuildTable, heavyBuildBuffer);
 
-    if(groupReturnAggregateFunction == "AVG") {
-        groupReturnAggregateColumnRes /= rowCount;
-    }
-            
-    if(groupBinaryOperator == LESS_THAN) {
-        if(groupAggregateColumnRes < groupAggregateColumnValue) {
-            rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-            this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+    for (uint pageCounter = 0; pageCounter < probeTable->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(probeTable->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < probeTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            const vector<int> &probeRow = page.getRowReference(rowCounter);
+            if (filter && !filter->mayContain(probeRow[probeColumnIndex]))
+            {
+                filter->eliminatedRowCount++;
+                continue;
+            }
+            if (heavyProbeTable && heavyKeys.count(probeRow[probeColumnIndex]))
+            {
+                appendRow(heavyProbeTable, heavyProbeBuffer, probeRow);
+                continue;
+            }
+            int partitionIndex = partitionOf(probeRow[probeColumnIndex]);
+            if (partitionIndex != -1)
+            {
+                appendRow(probePartitions[partitionIndex], probeBuffers[partitionIndex], probeRow);
+                continue;
+            }
+            auto matches = hashTable.equal_range(probeRow[probeColumnIndex]);
+            for (auto match = matches.first; match != matches.second; match++)
+                emit(buildRows[match->second], probeRow);
         }
     }
-    else if(groupBinaryOperator == LEQ) {
-        if(groupAggregateColumnRes <= groupAggregateColumnValue) {
-            rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-            this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+    buildRows.clear();
+    hashTable.clear();
+
+    for (uint partitionCounter = 0; partitionCounter < buildPartitions.size(); partitionCounter++)
+    {
+        Table *buildPartition = buildPartitions[partitionCounter];
+        Table *probePartition = probePartitions[partitionCounter];
+        flushBuffer(probePartition, probeBuffers[partitionCounter]);
+
+        // The smaller side of each pair of partitions is built
+        if (buildPartition->rowCount > 0 && probePartition->rowCount > 0)
+        {
+            if (make_pair(buildPartition->blockCount, buildPartition->rowCount) <= make_pair(probePartition->blockCount, probePartition->rowCount))
+                this->hashJoinPartition(buildPartition, probePartition, buildColumnIndex, probeColumnIndex, buildIsFirst, level + 1, memoryPageCount, rows);
+            else
+                this->hashJoinPartition(probePartition, buildPartition, probeColumnIndex, buildColumnIndex, !buildIsFirst, level + 1, memoryPageCount, rows);
         }
+        tableCatalogue.deleteTable(buildPartition->tableName);
+        tableCatalogue.deleteTable(probePartition->tableName);
     }
-    else if(groupBinaryOperator == GREATER_THAN) {
-        if(groupAggregateColumnRes > groupAggregateColumnValue) {
-            rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-            this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+
+    if (heavyBuildTable)
+    {
+        flushBuffer(heavyProbeTable, heavyProbeBuffer);
+        if (heavyBuildTable->rowCount > 0 && heavyProbeTable->rowCount > 0)
+        {
+            if (make_pair(heavyBuildTable->blockCount, heavyBuildTable->rowCount) <= make_pair(heavyProbeTable->blockCount, heavyProbeTable->rowCount))
+                this->hashJoinPartition(heavyBuildTable, heavyProbeTable, buildColumnIndex, probeColumnIndex, buildIsFirst, MAX_PARTITIONING_LEVEL, memoryPageCount, rows);
+            else
+                this->hashJoinPartition(heavyProbeTable, heavyBuildTable, probeColumnIndex, buildColumnIndex, !buildIsFirst, MAX_PARTITIONING_LEVEL, memoryPageCount, rows);
         }
+        tableCatalogue.deleteTable(heavyBuildTable->tableName);
+        tableCatalogue.deleteTable(heavyProbeTable->tableName);
     }
-    else if(groupBinaryOperator == GEQ) {
-        if(groupAggregateColumnRes >= groupAggregateColumnValue) {
-            rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-            this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+}
+
+/**
+ * @brief Left-deep multi-way equi-join tables[0] ⋈ tables[1] ⋈ ... written to
+ * this table. joinColumnIndices[k] pairs a column of the tuples joined so far,
+ * indexed across the columns of tables[0..k], with a column of tables[k + 1].
+ *
+ * Every relation but the first is loaded into an in-memory hash table on its
+ * join column, the caller makes sure they fit together, and the first
+ * relation is streamed through the chain of probes a page at a time. Tuples
+ * are passed from one probe to the next in batches of a page's worth of rows
+ * and are never written out, only the final tuples are.
+ *
+ * @param tables 
+ * @param joinColumnIndices 
+ */
+void Table::multiJoinTable(vector<Table*> tables, vector<pair<int, int>> joinColumnIndices)
+{
+    logger.log("Table::multiJoinTable");
+
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+
+    uint stageCount = tables.size() - 1;
+    vector<vector<vector<int>>> buildRows(stageCount);
+    vector<unordered_multimap<int, uint>> hashTables(stageCount);
+    vector<uint> batchSizes(stageCount);
+    uint tupleWidth = tables[0]->columnCount;
+    for (uint stageCounter = 0; stageCounter < stageCount; stageCounter++)
+    {
+        Table *buildTable = tables[stageCounter + 1];
+        for (uint pageCounter = 0; pageCounter < buildTable->blockCount; pageCounter++)
+        {
+            Page page = bufferManager.getPage(buildTable->tableName, pageCounter, false);
+            for (uint rowCounter = 0; rowCounter < buildTable->rowsPerBlockCount[pageCounter]; rowCounter++)
+            {
+                buildRows[stageCounter].push_back(page.getRowReference(rowCounter));
+                hashTables[stageCounter].insert({buildRows[stageCounter].back()[joinColumnIndices[stageCounter].second], buildRows[stageCounter].size() - 1});
+            }
         }
+        tupleWidth += buildTable->columnCount;
+        batchSizes[stageCounter] = max(1u, (uint)((BLOCK_SIZE * 1000) / (sizeof(int) * tupleWidth)));
     }
-    else {
-        if(groupAggregateColumnRes == groupAggregateColumnValue) {
-            rows.push_back({prevColumnVal, groupReturnAggregateColumnRes});
-            this->updateStatistics({prevColumnVal, groupReturnAggregateColumnRes});
+
+    // batches[k] holds the tuples waiting to be probed against tables[k + 1],
+    // batches[stageCount] the joined tuples
+    vector<vector<vector<int>>> batches(stageCount + 1);
+    vector<vector<int>> rows;
+    function<void(uint)> probeStage = [&](uint stage) {
+        if (stage == stageCount)
+        {
+            for (auto &tuple : batches[stage])
+            {
+                rows.push_back(move(tuple));
+                this->updateStatistics(rows.back());
+                if (rows.size() == this->maxRowsPerBlock)
+                {
+                    bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+                    this->blockCount++;
+                    this->rowsPerBlockCount.emplace_back(rows.size());
+                    rows.clear();
+                }
+            }
+            batches[stage].clear();
+            return;
+        }
+
+        vector<vector<int>> &nextBatch = batches[stage + 1];
+        for (auto &tuple : batches[stage])
+        {
+            auto matches = hashTables[stage].equal_range(tuple[joinColumnIndices[stage].first]);
+            for (auto match = matches.first; match != matches.second; match++)
+            {
+                const vector<int> &buildRow = buildRows[stage][match->second];
+                nextBatch.emplace_back();
+                nextBatch.back().reserve(tuple.size() + buildRow.size());
+                nextBatch.back().insert(nextBatch.back().end(), tuple.begin(), tuple.end());
+                nextBatch.back().insert(nextBatch.back().end(), buildRow.begin(), buildRow.end());
+                if (nextBatch.size() == batchSizes[stage])
+                    probeStage(stage + 1);
+            }
         }
+        batches[stage].clear();
+        if (!nextBatch.empty())
+            probeStage(stage + 1);
+    };
+
+    for (uint pageCounter = 0; pageCounter < tables[0]->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(tables[0]->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < tables[0]->rowsPerBlockCount[pageCounter]; rowCounter++)
+            batches[0].push_back(page.getRowReference(rowCounter));
+        probeStage(0);
     }
-    
-    if(rows.size() > 0) {
+
+    if (rows.size() > 0)
+    {
         bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
         this->blockCount++;
         this->rowsPerBlockCount.emplace_back(rows.size());
         rows.clear();
     }
-
 }
 
-void Table::insertNewRow(vector<int> &row1, vector<int> &row2, vector<vector<int>> &rows) {
-    vector<int> currentRow;
-    currentRow.insert(currentRow.end(), row1.begin(), row1.end());
-    currentRow.insert(currentRow.end(), row2.begin(), row2.end());
-    rows.push_back(currentRow);
-    this->updateStatistics(currentRow);
+/**
+ * @brief Semi-join (or, if anti, anti-join) of table1 with table2 on
+ * joinFirstColumnIndex == joinSecondColumnIndex: the rows of table1 that have
+ * (or don't have) a match in table2, each written once and in the order of
+ * table1. Only the distinct join keys of table2 are kept in memory, in a hash
+ * set, and each row of table1 is decided with a single lookup.
+ *
+ * @param table1 
+ * @param table2 
+ * @param joinFirstColumnIndex 
+ * @param joinSecondColumnIndex 
+ * @param anti 
+ * @return true 
+ * @return false if the keys of table2 don't fit in memory, nothing is written
+ */
+bool Table::hashSemiJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, bool anti)
+{
+    logger.log("Table::hashSemiJoinTable");
 
-    if(rows.size() == this->maxRowsPerBlock) {
-        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
-        this->blockCount++;
-        this->rowsPerBlockCount.emplace_back(rows.size());
-        rows.clear();
+    size_t keyCapacity = memoryFrames(2) * (size_t)((BLOCK_SIZE * 1000) / sizeof(int));
+    unordered_set<int> keys;
+    for (uint pageCounter = 0; pageCounter < table2->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(table2->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < table2->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            keys.insert(page.getRowReference(rowCounter)[joinSecondColumnIndex]);
+            if (keys.size() > keyCapacity)
+                return false;
+        }
     }
-}
 
-void Table::joinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, BinaryOperator joinBinaryOperator) {
-    logger.log("Table::joinTable");
-    
     this->distinctValuesInColumns.assign(this->columnCount, {});
     this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
-    
     vector<vector<int>> rows;
-
-    Cursor cursor1(table1->tableName, 0);
-    Cursor cursor2(table2->tableName, 0);
-
-    vector<int> row1 = cursor1.getNext();
-    vector<int> row2 = cursor2.getNext();
-
-    while(!row1.empty() && !row2.empty()) {
-        if(joinBinaryOperator == EQUAL) {
-            if(row1[joinFirstColumnIndex] == row2[joinSecondColumnIndex]) {
-                insertNewRow(row1, row2, rows);
-
-                Cursor nextCursor1 = cursor1, nextCursor2 = cursor2;
-                vector<int> nextRow1 = nextCursor1.getNext(), nextRow2 = nextCursor2.getNext();
-                while(!nextRow1.empty()) {
-                    if(nextRow1[joinFirstColumnIndex] == row2[joinSecondColumnIndex]) {
-                        insertNewRow(nextRow1, row2, rows);
-                    }
-                    else {
-                        break;
-                    }
-
-                    nextRow1 = nextCursor1.getNext();
-                }
-
-                while(!nextRow2.empty()) {
-                    if(row1[joinFirstColumnIndex] == nextRow2[joinSecondColumnIndex]) {
-                        insertNewRow(row1, nextRow2, rows);
-                    }
-                    else {
-                        break;
-                    }
-
-                    nextRow2 = nextCursor2.getNext();
-                }
-
-                row1 = cursor1.getNext();
-                row2 = cursor2.getNext();
-            }
-            else if(row1[joinFirstColumnIndex] < row2[joinSecondColumnIndex]) {
-                row1 = cursor1.getNext();
-            }
-            else {
-                row2 = cursor2.getNext();
-            }
-        }
-        else if(joinBinaryOperator == GREATER_THAN) {
-            if(row1[joinFirstColumnIndex] > row2[joinSecondColumnIndex]) {
-                insertNewRow(row1, row2, rows);
-
-                Cursor nextCursor1 = cursor1;
-                vector<int> nextRow1 = nextCursor1.getNext();
-                while(!nextRow1.empty()) {
-                    insertNewRow(nextRow1, row2, rows);
-                    nextRow1 = nextCursor1.getNext();
-                }
-
-                row2 = cursor2.getNext();
-            }
-            else {
-                row1 = cursor1.getNext();
-            }
+    for (uint pageCounter = 0; pageCounter < table1->blockCount; pageCounter++)
+    {
+        Page page = bufferManager.getPage(table1->tableName, pageCounter, false);
+        for (uint rowCounter = 0; rowCounter < table1->rowsPerBlockCount[pageCounter]; rowCounter++)
+        {
+            const vector<int> &row = page.getRowReference(rowCounter);
+            if ((keys.count(row[joinFirstColumnIndex]) > 0) == anti)
+                continue;
+            this->insertNewRow(row, {}, rows);
         }
-        else if(joinBinaryOperator == LESS_THAN) {
-            if(row1[joinFirstColumnIndex] < row2[joinSecondColumnIndex]) {
-                insertNewRow(row1, row2, rows);
-
-                Cursor nextCursor2 = cursor2;
-                vector<int> nextRow2 = nextCursor2.getNext();
-                while(!nextRow2.empty()) {
-                    insertNewRow(row1, nextRow2, rows);
-                    nextRow2 = nextCursor2.getNext();
-                }
+    }
 
-                row1 = cursor1.getNext();
-            }
-            else {
-                row2 = cursor2.getNext();
-            }
-        }
-        else if(joinBinaryOperator == GEQ) {
-            if(row1[joinFirstColumnIndex] >= row2[joinSecondColumnIndex]) {
-                insertNewRow(row1, row2, rows);
+    if (rows.size() > 0)
+    {
+        bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
+        this->blockCount++;
+        this->rowsPerBlockCount.emplace_back(rows.size());
+        rows.clear();
+    }
+    return true;
+}
 
-                Cursor nextCursor1 = cursor1;
-                vector<int> nextRow1 = nextCursor1.getNext();
-                while(!nextRow1.empty()) {
-                    insertNewRow(nextRow1, row2, rows);
-                    nextRow1 = nextCursor1.getNext();
-                }
+/**
+ * @brief Semi-join (or, if anti, anti-join) of two tables sorted in ascending
+ * order on their join columns. Both are read forwards once. table2 is only
+ * moved past keys below the key of the current row of table1, so every row of
+ * table1 is decided by the first row of table2 not below its key.
+ *
+ * @param table1 
+ * @param table2 
+ * @param joinFirstColumnIndex 
+ * @param joinSecondColumnIndex 
+ * @param anti 
+ */
+void Table::mergeSemiJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, bool anti)
+{
+    logger.log("Table::mergeSemiJoinTable");
 
-                row2 = cursor2.getNext();
-            }
-            else {
-                row1 = cursor1.getNext();
-            }
-        }
-        else if(joinBinaryOperator == LEQ) {
-            if(row1[joinFirstColumnIndex] <= row2[joinSecondColumnIndex]) {
-                insertNewRow(row1, row2, rows);
+    this->distinctValuesInColumns.assign(this->columnCount, {});
+    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
+    if (table1->rowCount == 0)
+        return;
 
-                Cursor nextCursor2 = cursor2;
-                vector<int> nextRow2 = nextCursor2.getNext();
-                while(!nextRow2.empty()) {
-                    insertNewRow(row1, nextRow2, rows);
-                    nextRow2 = nextCursor2.getNext();
-                }
+    RunReader reader1({table1, 0, table1->blockCount, table1->rowCount});
+    unique_ptr<RunReader> reader2;
+    if (table2->rowCount > 0)
+        reader2.reset(new RunReader({table2, 0, table2->blockCount, table2->rowCount}));
 
-                row1 = cursor1.getNext();
-            }
-            else {
-                row2 = cursor2.getNext();
-            }
-        }
+    vector<vector<int>> rows;
+    for (; reader1.rowsRemaining > 0; reader1.advance())
+    {
+        const vector<int> &row = reader1.currentRow();
+        int key = row[joinFirstColumnIndex];
+        while (reader2 && reader2->rowsRemaining > 0 && reader2->currentRow()[joinSecondColumnIndex] < key)
+            reader2->advance();
+        bool matched = reader2 && reader2->rowsRemaining > 0 && reader2->currentRow()[joinSecondColumnIndex] == key;
+        if (matched != anti)
+            this->insertNewRow(row, {}, rows);
     }
 
-    if(rows.size() > 0) {
+    if (rows.size() > 0)
+    {
         bufferManager.writePage(this->tableName, this->blockCount, rows, rows.size());
         this->blockCount++;
         this->rowsPerBlockCount.emplace_back(rows.size());
         rows.clear();
     }
-}
\ No newline at end of file
+}
@@ -25,6 +25,103 @@ enum BinaryOperator
     NO_BINOP_CLAUSE
 };
 
+/**
+ * @brief Orders rows on a list of columns, each of which is sorted in
+ * ascending or descending order. Keys of up to two columns can also be
+ * encoded as a normalized 64 bit unsigned integer that orders the same way,
+ * which lets the sort compare keys with a single instruction and radix sort
+ * them.
+ *
+ */
+struct RowComparator
+{
+    vector<int> columnIndices;
+    vector<SortingStrategy> sortStrategyList;
+    bool operator()(const vector<int> &a, const vector<int> &b) const;
+    bool hasNormalizedKey() const;
+    unsigned long long normalizedKey(const vector<int> &row) const;
+};
+
+class Table;
+
+/**
+ * @brief A sorted run produced by the external sort. A run occupies pageCount
+ * consecutive pages of table, starting at row firstRow of page firstPage.
+ * fenceRows holds the first row of every page of the run, it is used to pick
+ * splitters and to find them in the run without reading it.
+ *
+ */
+struct SortRun
+{
+    Table *table;
+    uint firstPage;
+    uint pageCount;
+    long long int rowCount;
+    uint firstRow = 0;
+    vector<vector<int>> fenceRows;
+};
+
+/**
+ * @brief Entry of a table index: the page and row at which a key value is
+ * stored. The index relation holds one entry per row, as the columns key,
+ * pageIndex and rowIndex, sorted on the key (see Table::buildIndex).
+ *
+ */
+struct IndexEntry
+{
+    int key;
+    uint pageIndex;
+    uint rowIndex;
+};
+
+unsigned long long hashJoinKey(int key, int level);
+unsigned long long hashGroupKey(const vector<int> &key, int level);
+
+enum AggregateFunction
+{
+    AGGREGATE_SUM,
+    AGGREGATE_MAX,
+    AGGREGATE_MIN,
+    AGGREGATE_AVG,
+    AGGREGATE_COUNT
+};
+
+/**
+ * @brief An aggregate function of GROUP BY over a column of the grouped
+ * relation. columnIndex is -1 for COUNT(*). The kernel that folds column
+ * values into the aggregate's state, and the identity the state starts from,
+ * are resolved from the function when the aggregate is created.
+ *
+ */
+struct GroupAggregate
+{
+    AggregateFunction aggregateFunction;
+    int columnIndex;
+    void (*kernel)(long long int &state, const int *values, size_t valueCount);
+    long long int identity;
+
+    GroupAggregate(AggregateFunction aggregateFunction, int columnIndex);
+};
+
+/**
+ * @brief Bloom filter on the join keys of one side of a join. Rows of the
+ * other side whose key fails the filter can't match and are dropped early. It
+ * is sized for about 1% false positives, 10 bits and 7 hash functions per key.
+ *
+ */
+struct BloomFilter
+{
+    vector<unsigned long long> words;
+    unsigned long long bitCount;
+    int hashCount = 7;
+    long long int eliminatedRowCount = 0;
+
+    BloomFilter(long long int keyCount);
+    void insert(int key);
+    bool mayContain(int key) const;
+    void merge(const BloomFilter &other);
+};
+
 /**
  * @brief The Table class holds all information related to a loaded table. It
  * also implements methods that interact with the parsers, executors, cursors
@@ -51,6 +148,9 @@ public:
     bool indexed = false;
     string indexedColumn = "";
     IndexingStrategy indexingStrategy = NOTHING;
+    string indexTableName = "";
+    vector<int> indexFenceKeys;
+    vector<pair<int, SortingStrategy>> sortOrder;
     
     bool extractColumnNames(string firstLine);
     bool blockify();
@@ -68,10 +168,44 @@ public:
     Cursor getCursor();
     int getColumnIndex(string columnName);
     void unload();
+    void writePage(uint pageIndex, const vector<vector<int>> &rows, uint rowCount);
+    future<void> writePageAsync(uint pageIndex, const vector<vector<int>> &rows, uint rowCount);
+    void reservePages(uint pageCount);
+    Table* createRunTable(string runTableName);
+    void appendOutputTables(const vector<Table*> &outputTables);
+    vector<SortRun> generateSortedRuns(Table *runTable, uint firstPageIndex, uint lastPageIndex, uint memoryPageCount, const RowComparator &comparator);
+    vector<SortRun> generateRunsByRadixSort(Table *runTable, uint firstPageIndex, uint lastPageIndex, uint memoryPageCount, const RowComparator &comparator);
+    vector<SortRun> generateRunsByReplacementSelection(Table *runTable, uint firstPageIndex, uint lastPageIndex, uint memoryPageCount, const RowComparator &comparator);
+    SortRun mergeSortedRuns(vector<SortRun> runs, uint firstPageIndex, const RowComparator &comparator);
+    long long int findRowInRun(const SortRun &run, const vector<int> &row, const RowComparator &comparator);
+    SortRun sliceSortRun(const SortRun &run, long long int firstRowOffset, long long int lastRowOffset);
+    void partitionedMergeSortedRuns(vector<SortRun> runs, uint partitionCount, const RowComparator &comparator);
+    void sortInMemory(const RowComparator &comparator);
     void sortTable(vector<int> columnIndices, vector<SortingStrategy> sortStrategyList);
-    void groupTable(Table* tempTable, int groupColumnIndex, BinaryOperator groupBinaryOperator, int groupAggregateColumnValue, string groupAggregateFunction, int groupAggregateColumnIndex, string groupReturnAggregateFunction, int groupReturnAggregateColumnIndex);
-    void joinTable(Table *table1, Table *table2, int FirstJoinColumnIndex, int SecondJoinColumnIndex, BinaryOperator joinBinaryOperator);
-    void insertNewRow(vector<int> &row1, vector<int> &row2, vector<vector<int>> &rows);
+    bool isSortedOn(const vector<int> &columnIndices, const vector<SortingStrategy> &sortStrategyList);
+    Table* createCopy(string copyTableName, vector<int> columnIndices, vector<SortingStrategy> sortStrategyList);
+    void topKTable(Table *table, vector<int> columnIndices, vector<SortingStrategy> sortStrategyList, long long int limit);
+    void truncate(long long int rowLimit);
+    void writeGroupRow(const vector<int> &groupKey, const vector<GroupAggregate> &aggregates, const long long int *state, BinaryOperator havingBinaryOperator, int havingValue, vector<vector<int>> &rows);
+    void groupTable(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue);
+    void hashGroupTable(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue);
+    void hashGroupPartition(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue, int level, uint memoryPageCount, vector<vector<int>> &rows, bool mergePartialStates = false);
+    void parallelHashGroupTable(Table *table, const vector<int> &groupColumnIndices, const vector<GroupAggregate> &aggregates, BinaryOperator havingBinaryOperator, int havingValue);
+    void joinTable(Table *table1, Table *table2, int FirstJoinColumnIndex, int SecondJoinColumnIndex);
+    void crossTable(Table *table1, Table *table2);
+    void inequalityJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, BinaryOperator joinBinaryOperator);
+    void buildIndex(string columnName, IndexingStrategy indexingStrategy);
+    void dropIndex();
+    void indexJoinTable(Table *outerTable, Table *indexedTable, int outerColumnIndex, bool outerIsFirst);
+    void insertNewRow(const vector<int> &row1, const vector<int> &row2, vector<vector<int>> &rows);
+    void hashJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex);
+    void parallelHashJoinTable(Table *buildTable, Table *probeTable, int buildColumnIndex, int probeColumnIndex, bool buildIsFirst, BloomFilter *filter);
+    void hashJoinPartition(Table *buildTable, Table *probeTable, int buildColumnIndex, int probeColumnIndex, bool buildIsFirst, int level, uint memoryPageCount, vector<vector<int>> &rows, BloomFilter *filter = nullptr);
+    vector<vector<int>> findHeavyGroupKeys(const vector<int> &columnIndices, long long int rowThreshold);
+    unordered_set<int> findHeavyKeys(int columnIndex, long long int rowThreshold);
+    void multiJoinTable(vector<Table*> tables, vector<pair<int, int>> joinColumnIndices);
+    bool hashSemiJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, bool anti);
+    void mergeSemiJoinTable(Table *table1, Table *table2, int joinFirstColumnIndex, int joinSecondColumnIndex, bool anti);
 
     /**
  * @brief Static function that takes a vector of valued and prints them out in a
@@ -83,7 +217,7 @@ public:
 template <typename T>
 void writeRow(vector<T> row, ostream &fout)
 {
-    logger.log("Table::printRow");
+    LOG_TRACE("Table::writeRow");
     for (int columnCounter = 0; columnCounter < row.size(); columnCounter++)
     {
         if (columnCounter != 0)
@@ -103,7 +237,7 @@ void writeRow(vector<T> row, ostream &fout)
 template <typename T>
 void writeRow(vector<T> row)
 {
-    logger.log("Table::printRow");
+    LOG_TRACE("Table::writeRow");
     ofstream fout(this->sourceFileName, ios::app);
     this->writeRow(row, fout);
     fout.close();
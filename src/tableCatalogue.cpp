@@ -3,24 +3,33 @@
 void TableCatalogue::insertTable(Table* table)
 {
     logger.log("TableCatalogue::~insertTable"); 
+    unique_lock<shared_mutex> lock(this->catalogueMutex);
     this->tables[table->tableName] = table;
 }
 void TableCatalogue::deleteTable(string tableName)
 {
     logger.log("TableCatalogue::deleteTable"); 
-    this->tables[tableName]->unload();
-    delete this->tables[tableName];
-    this->tables.erase(tableName);
+    Table *table;
+    {
+        unique_lock<shared_mutex> lock(this->catalogueMutex);
+        table = this->tables[tableName];
+        this->tables.erase(tableName);
+    }
+    table->dropIndex();
+    table->unload();
+    delete table;
 }
 Table* TableCatalogue::getTable(string tableName)
 {
-    logger.log("TableCatalogue::getTable"); 
-    Table *table = this->tables[tableName];
-    return table;
+    LOG_DEBUG("TableCatalogue::getTable"); 
+    shared_lock<shared_mutex> lock(this->catalogueMutex);
+    auto table = this->tables.find(tableName);
+    return table == this->tables.end() ? nullptr : table->second;
 }
 bool TableCatalogue::isTable(string tableName)
 {
-    logger.log("TableCatalogue::isTable"); 
+    LOG_DEBUG("TableCatalogue::isTable"); 
+    shared_lock<shared_mutex> lock(this->catalogueMutex);
     if (this->tables.count(tableName))
         return true;
     return false;
@@ -46,6 +55,9 @@ void TableCatalogue::print()
     int rowCount = 0;
     for (auto rel : this->tables)
     {
+        // Relations starting with $ are kept internally, such as indexes
+        if (rel.first[0] == '$')
+            continue;
         cout << rel.first << endl;
         rowCount++;
     }
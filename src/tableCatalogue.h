@@ -3,13 +3,16 @@
 /**
  * @brief The TableCatalogue acts like an index of tables existing in the
  * system. Everytime a table is added(removed) to(from) the system, it needs to
- * be added(removed) to(from) the tableCatalogue. 
+ * be added(removed) to(from) the tableCatalogue. Operators running on worker
+ * threads add and remove temporary tables, so the catalogue is guarded by
+ * catalogueMutex.
  *
  */
 class TableCatalogue
 {
 
     unordered_map<string, Table*> tables;
+    shared_mutex catalogueMutex;
 
 public:
     TableCatalogue() {}